@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include "AdjList.hpp"
+
+namespace Graph {
+
+using Edge = std::pair<int, int>;
+
+// Read-only view over a contiguous, sorted neighbor array
+class NodeRange {
+public:
+    using value_type = int;
+    using const_iterator = const int*;
+
+    NodeRange() = default;
+    NodeRange(const int* first, const int* last) : first(first), last(last) {}
+
+    const int* begin() const { return first; }
+    const int* end() const { return last; }
+    std::size_t size() const { return static_cast<std::size_t>(last - first); }
+    bool empty() const { return first == last; }
+    int operator[](std::size_t i) const { return first[i]; }
+
+private:
+    const int* first = nullptr;
+    const int* last = nullptr;
+};
+
+// Frozen compressed-sparse-row graph (forward and reverse adjacency).
+// External node IDs are compacted to dense indices 0..n-1 (in ascending ID
+// order); every accessor except id()/index() works on dense indices. Built
+// from an AdjList, nodes without edges are kept.
+class CSRGraph {
+private:
+    std::vector<int> ids;
+    std::vector<std::size_t> outOffsets, inOffsets;
+    std::vector<int> outEdges, inEdges;
+
+    // ids are every edge endpoint plus the given nodes
+    void build(std::vector<Edge> edges, std::vector<int> nodes = {});
+
+public:
+    CSRGraph() = default;
+    explicit CSRGraph(const AdjList& adj);
+    explicit CSRGraph(std::vector<Edge> edges);
+
+    static CSRGraph loadCSV(const std::string& filepath);
+
+    // --- ID translation ---
+    int id(int node) const;
+    int index(int id) const;
+
+    // --- Neighbor access ---
+    NodeRange out(int node) const;
+    NodeRange in(int node) const;
+    int outDegree(int node) const;
+    int inDegree(int node) const;
+
+    // --- Edge presence checks ---
+    bool hasEdge(int src, int dst) const;
+
+    // --- Information access ---
+    const std::vector<int>& getIds() const;
+    std::size_t size() const;
+    std::size_t edgeCount() const;
+    std::size_t bytes() const;
+    bool empty() const;
+};
+
+} // namespace Graph
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "AdjList.hpp"
+#include "CSRGraph.hpp"
+#include "PreparedGraph.hpp"
+#include "Refinement.hpp"
+#include "SearchBudget.hpp"
+
+namespace Graph {
+
+// Canonical relabeling of a graph. Isomorphic graphs get identical edges and
+// certificates; different edges mean the graphs are not isomorphic.
+struct CanonicalForm {
+    // labeling[i]: canonical position of dense node i (ascending-ID order)
+    std::vector<int> labeling;
+    // Relabeled edge list, sorted
+    std::vector<Edge> edges;
+    // "<nodes>:<edges>:<128-bit hash of edges>", stable across runs
+    std::string certificate;
+    // Automorphisms met during the search (dense node -> dense node); they
+    // generate a subgroup of the automorphism group, not necessarily all of it
+    std::vector<std::vector<int>> automorphisms;
+    // False if the budget ran out; labeling, edges and certificate are then
+    // empty (automorphisms found so far are still valid)
+    bool complete = true;
+};
+
+class Canonical {
+public:
+    // The search spends one budget node per tree node and gives up (complete
+    // = false) once the budget is exhausted; nullptr searches to the end
+    static CanonicalForm label(const AdjList& adj, SearchBudget* budget = nullptr);
+    static CanonicalForm label(const CSRGraph& graph, SearchBudget* budget = nullptr, int threads = 1);
+    static CanonicalForm label(const PreparedGraph& graph, SearchBudget* budget = nullptr);
+    static CanonicalForm label(const CSRGraph& graph, const std::map<FeatPrint, NodeSet>& feat, SearchBudget* budget = nullptr);
+
+    // Automorphisms only, found against the first leaf instead of the
+    // canonical one, so every branch off its trace is cut. Stops quietly
+    // after maxNodes tree nodes (0 = unlimited) with the automorphisms found
+    // so far; check budget->exhausted() for the budget.
+    static std::vector<std::vector<int>> automorphisms(
+        const CSRGraph& graph, const std::map<FeatPrint, NodeSet>& feat,
+        SearchBudget* budget = nullptr, std::size_t maxNodes = 0);
+
+private:
+    struct Search;
+};
+
+} // namespace Graph
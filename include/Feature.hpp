@@ -2,10 +2,13 @@
 
 #include <map>
 #include <set>
+#include <vector>
+#include <cstdint>
 #include <unordered_map>
 #include <unordered_set>
 #include "Utils.hpp"
 #include "AdjList.hpp"
+#include "CSRGraph.hpp"
 
 namespace Graph {
 
@@ -14,14 +17,50 @@ using Degs = std::pair<int, int>;
 using DSet = std::multiset<int>;
 using FeatSig = std::map<Degs, std::multiset<DSet>>;
 
+// Compact form of a FeatSig: one 64-bit hash per (source degrees, distance
+// set) entry, sorted, plus a hash of that vector. Ordering compares the hash
+// first and falls back to the entry hashes when two hashes collide; the
+// entries themselves are not kept, so two signatures whose entries collide
+// compare equal. Such a collision depends only on the entries, so it merges
+// the same classes in every graph: partitions get coarser, never
+// inconsistent, and the solvers stay exact.
+struct FeatPrint {
+    uint64_t hash = 0;
+    std::vector<uint64_t> sig;
+
+    bool operator==(const FeatPrint& other) const {
+        return hash == other.hash && sig == other.sig;
+    }
+    bool operator!=(const FeatPrint& other) const { return !(*this == other); }
+    bool operator<(const FeatPrint& other) const {
+        if (hash != other.hash) return hash < other.hash;
+        return sig < other.sig;
+    }
+};
+
 class Feature {
 public:
     static std::map<FeatSig, NodeSet> gen(const AdjList& adj);
-    static std::vector<int> genkWL(const AdjList& adj, int k, int maxIter = 20);
-
-private:
-    static std::unordered_map<int, DSet> genFeatState(int n, const NodeSet& nodes, const AdjList& adj, const AdjList& rev);
-    static std::vector<std::vector<int>> genTuples(const NodeSet& nodes, int k);
+    // Node sets hold dense indices of graph (the AdjList overload reports IDs).
+    // threads <= 0 uses every hardware thread.
+    static std::map<FeatSig, NodeSet> gen(const CSRGraph& graph, int threads = 1);
+    // Same partition as gen() (up to 64-bit entry hash collisions) at a
+    // fraction of the memory; node sets hold dense indices
+    static std::map<FeatPrint, NodeSet> genPrint(const CSRGraph& graph, int threads = 1);
+    // k-dimensional WL coloring of all n^k node tuples, addressed by their
+    // mixed-radix index over a dense node order (4 bytes per tuple in each
+    // of two color buffers); returns the sorted color ids. Rounds run on
+    // `threads` workers (<= 0: all) with results independent of the count.
+    static std::vector<int> genkWL(const AdjList& adj, int k, int maxIter = 20, int threads = 1);
+    // Refines the tuples of both graphs with one shared color numbering per
+    // round and stops at the first round whose color histograms differ.
+    // false proves the graphs non-isomorphic; true means k-WL cannot
+    // distinguish them within maxIter rounds.
+    static bool kWLEquivalent(const AdjList& adjA, const AdjList& adjB, int k, int maxIter = 20, int threads = 1);
+    // Same test with local k-WL: only connected k-tuples are colored, and a
+    // position is refined through the neighbors of the node it holds, so the
+    // cost grows with the edge count instead of n^k
+    static bool localkWLEquivalent(const CSRGraph& graphA, const CSRGraph& graphB, int k, int maxIter = 20, int threads = 1);
 };
 
 } // namespace Graph
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <cstddef>
+#include "PreparedGraph.hpp"
+
+namespace Graph {
+
+// Path-keyed LRU cache of PreparedGraphs. With a nonzero byte limit the least
+// recently used entries are dropped (and reloaded on the next get) once the
+// estimated footprint exceeds it; the most recent entry is always kept.
+class GraphCache {
+public:
+    using Ptr = std::shared_ptr<const PreparedGraph>;
+
+    explicit GraphCache(std::size_t maxBytes = 0, int threads = 1);
+
+    Ptr get(const std::string& filepath);
+    void put(const std::string& filepath, Ptr graph);
+    bool contains(const std::string& filepath) const;
+    void clear();
+
+    // --- Information access ---
+    std::size_t size() const;
+    std::size_t bytes() const;
+    std::size_t hits() const;
+    std::size_t misses() const;
+
+private:
+    using Entry = std::pair<std::string, Ptr>;
+
+    std::size_t maxBytes;
+    int threads;
+    std::size_t usedBytes = 0;
+    std::size_t hitCount = 0, missCount = 0;
+
+    std::list<Entry> entries;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+
+    void evict();
+};
+
+} // namespace Graph
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <map>
+#include <cstdint>
+#include "CSRGraph.hpp"
+#include "Feature.hpp"
+
+namespace Graph {
+
+// Cheap relabeling-invariant graph hashes. Isomorphic graphs always hash
+// equal, so different hashes prove non-isomorphism; equal hashes prove nothing.
+class Invariant {
+public:
+    // Combines the degree, feature and WL hashes below
+    static uint64_t hash(const CSRGraph& graph, int threads = 1);
+    static uint64_t hash(const CSRGraph& graph, const std::map<FeatPrint, NodeSet>& feat);
+
+    // Node/edge counts and the sorted (out, in) degree sequence
+    static uint64_t hashDegrees(const CSRGraph& graph);
+    // Histogram of distance-signature fingerprints from Feature::genPrint
+    static uint64_t hashFeatures(const std::map<FeatPrint, NodeSet>& feat);
+    // Color histogram of directed 1-WL refinement, run until the number of
+    // colors stops growing (at most maxIter rounds)
+    static uint64_t hashWL(const CSRGraph& graph, int maxIter = 20);
+};
+
+} // namespace Graph
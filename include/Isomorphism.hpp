@@ -1,50 +1,176 @@
 #pragma once
 
+#include <atomic>
 #include <vector>
+#include <unordered_map>
 #include <unordered_set>
 #include "Utils.hpp"
 #include "AdjList.hpp"
+#include "CSRGraph.hpp"
 #include "Feature.hpp"
+#include "PreparedGraph.hpp"
+#include "Refinement.hpp"
+#include "SearchBudget.hpp"
+#include "SolverStats.hpp"
 
 namespace Graph {
 
 using NodeMap = std::vector<int>;
+using IdMap = std::unordered_map<int, int>;
 using Group = std::vector<int>;
 using GroupPair = std::pair<Group, Group>;
 using GroupList = std::vector<GroupPair>;
 
+// Search position: (group, index within the group)
+using Position = std::pair<int, int>;
+using PositionList = std::vector<Position>;
+
+// Search domains by feature group: the group of every graphA node, and for
+// every graphB node the sorted, distinct groups among its out-/in-neighbors.
+// Asking whether an unmapped neighbor can still land next to a mapped node
+// is then one binary search instead of a set intersection.
+struct GroupIndex {
+    std::vector<int> groupA;
+    std::vector<std::size_t> outOffsets, inOffsets;
+    std::vector<int> outGroups, inGroups;
+
+    void build(const CSRGraph& graphA, const CSRGraph& graphB, const GroupList& groups);
+    bool reaches(int nodeB, int group, bool forward) const;
+};
+
+enum class Engine {
+    Groups,  // Permutation search within feature groups
+    Refine,  // Individualization-refinement on the feature coloring
+    VF2      // VF2++ state-space matching with feature groups as labels
+};
+
+struct SolverOptions {
+    Engine engine = Engine::Groups;
+
+    // Worker threads for feature generation and the search; <= 0 uses every
+    // hardware thread. With more than one, the top levels of the group search
+    // tree are split into tasks on work-stealing deques.
+    int threads = 1;
+
+    // Group engine: if the search is not settled within a few nodes per
+    // node, collect automorphisms of graphB (Canonical::automorphisms, capped)
+    // and search again, skipping candidates that are orbit-equivalent to an
+    // already failed one. Pays off on highly symmetric, non-isomorphic pairs.
+    bool automorphisms = false;
+
+    // k > 0 runs local k-WL on both graphs (Feature::localkWLEquivalent)
+    // after the feature partitions match and before the search; separates
+    // hard non-isomorphic pairs without searching. Not interrupted by limits.
+    int localWL = 0;
+
+    // Search limits (0 / nullptr = none). A search that runs into one gives
+    // Result::Unknown. The limits cover every search of the call, including
+    // the automorphism pre-pass; the time limit also counts feature
+    // generation and the localWL check, which are not interrupted themselves.
+    std::chrono::milliseconds timeLimit{0};
+    std::size_t nodeLimit = 0;
+    const std::atomic<bool>* cancel = nullptr;
+
+    // Filled with timings and search counters by match()/solver() when the
+    // library is built with GRAPH_STATS (make STATS=1); left zero otherwise
+    SolverStats* stats = nullptr;
+};
+
+enum class Result {
+    NotIsomorphic,
+    Isomorphic,
+    Unknown  // a limit or the cancellation flag stopped the search
+};
+
 class Isomorphism {
 public:
-    static bool solver(const AdjList& adjA, const AdjList& adjB);
-    static bool solver(const AdjList& adjA, const AdjList& adjB, NodeMap& maps);
+    static bool solver(const AdjList& adjA, const AdjList& adjB, const SolverOptions& options = {});
+    static bool solver(const AdjList& adjA, const AdjList& adjB, IdMap& maps, const SolverOptions& options = {});
+
+    static bool solver(const CSRGraph& graphA, const CSRGraph& graphB, const SolverOptions& options = {});
+
+    // Dense-index overload: maps[i] is the index in graphB matched to index i of graphA
+    static bool solver(const CSRGraph& graphA, const CSRGraph& graphB, NodeMap& maps, const SolverOptions& options = {});
+
+    // Reuses the partitions and degree data of prepared graphs (dense indices)
+    static bool solver(const PreparedGraph& graphA, const PreparedGraph& graphB, const SolverOptions& options = {});
+    static bool solver(const PreparedGraph& graphA, const PreparedGraph& graphB, NodeMap& maps, const SolverOptions& options = {});
+
+    // Tri-state variants of the dense-index solvers; solver() reports
+    // Unknown as false
+    static Result match(const CSRGraph& graphA, const CSRGraph& graphB, NodeMap& maps, const SolverOptions& options = {});
+    static Result match(const PreparedGraph& graphA, const PreparedGraph& graphB, NodeMap& maps, const SolverOptions& options = {});
 
 private:
+    class OrbitPruner;
+
+    static Result solve(
+        const CSRGraph& graphA, const std::map<FeatPrint, NodeSet>& featA,
+        const CSRGraph& graphB, const std::map<FeatPrint, NodeSet>& featB,
+        NodeMap& maps,
+        const SolverOptions& options,
+        SearchBudget& budget,
+        SolverStats* stats
+    );
+
+    // Numbers both feature partitions in fingerprint order; false if they differ
+    static bool featureColors(
+        const std::map<FeatPrint, NodeSet>& featA,
+        const std::map<FeatPrint, NodeSet>& featB,
+        Colors& colorsA, Colors& colorsB
+    );
+
     static bool setGroups(
-        const std::map<FeatSig, NodeSet>& featA,
-        const std::map<FeatSig, NodeSet>& featB,
-        GroupList& groups,
-        std::vector<NodeSet>& nodeToGroup
+        const std::map<FeatPrint, NodeSet>& featA,
+        const std::map<FeatPrint, NodeSet>& featB,
+        GroupList& groups
     );
 
+    static PositionList orderPositions(const CSRGraph& graphA, GroupList& groups);
+
     static bool matchGroups(
-        const AdjList& adjA, const AdjList& revA,
-        const AdjList& adjB, const AdjList& revB,
+        const CSRGraph& graphA, const CSRGraph& graphB,
         GroupList& groups,
-        const std::vector<NodeSet>& nodeToGroup,
+        const PositionList& positions,
+        const GroupIndex& index,
+        NodeMap& maps,
+        SearchBudget& budget,
+        int start = 0,
+        std::size_t verified = 0,
+        OrbitPruner* pruner = nullptr,
+        SolverStats* stats = nullptr
+    );
+
+    static bool matchParallel(
+        const CSRGraph& graphA, const CSRGraph& graphB,
+        const GroupList& groups,
+        const PositionList& positions,
+        const GroupIndex& index,
+        NodeMap& maps,
+        SearchBudget& budget,
+        int threads,
+        const std::vector<std::vector<int>>& automorphisms,
+        SolverStats* stats
+    );
+
+    static bool matchRefine(
+        const CSRGraph& graphA, const CSRGraph& graphB,
+        const Colors& colorsA, const Colors& colorsB,
         NodeMap& maps,
-        int groupIdx = 0,
-        int permIdx = 0
+        SearchBudget& budget
     );
 
+    // Checks the edges between srcA and already mapped nodes and adds the
+    // number of graphA edges it closed to `closed`
     static bool verifySubMapping(
-        const AdjList& adjA, const AdjList& revA,
-        const AdjList& adjB, const AdjList& revB,
+        const CSRGraph& graphA, const CSRGraph& graphB,
         const NodeMap& maps,
         int srcA,
-        const std::vector<NodeSet>& nodeToGroup
+        const GroupIndex& index,
+        std::size_t& closed
     );
 
-    static bool verifyMapping(const AdjList& adjA, const AdjList& adjB, const NodeMap& maps);
+    static bool verifyMapping(const CSRGraph& graphA, const CSRGraph& graphB, const NodeMap& maps);
 };
 
 } // namespace Graph
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "AdjList.hpp"
+#include "CSRGraph.hpp"
+#include "Feature.hpp"
+
+namespace Graph {
+
+// Everything the solver derives from a single graph, computed once so one
+// graph can be compared against many: the frozen forward/reverse adjacency,
+// the fingerprint partition and the sorted (out, in) degree sequence.
+class PreparedGraph {
+private:
+    CSRGraph graph;
+    std::map<FeatPrint, NodeSet> feat;
+    std::vector<Degs> degs;
+
+public:
+    PreparedGraph() = default;
+    explicit PreparedGraph(CSRGraph graph, int threads = 1);
+    explicit PreparedGraph(const AdjList& adj, int threads = 1);
+
+    static PreparedGraph loadCSV(const std::string& filepath, int threads = 1);
+
+    // --- Information access ---
+    const CSRGraph& getGraph() const;
+    const std::map<FeatPrint, NodeSet>& getFeatures() const;
+    const std::vector<Degs>& getDegrees() const;
+    std::size_t bytes() const;
+};
+
+} // namespace Graph
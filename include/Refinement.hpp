@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+#include "CSRGraph.hpp"
+
+namespace Graph {
+
+using Colors = std::vector<int>;
+
+// Color refinement towards the coarsest equitable partition: a node's new
+// color is derived from its old color and the multisets of its out- and
+// in-neighbors' colors, repeated until the number of colors stops growing.
+// New colors are numbered by the sorted (old color, signature) order, which
+// does not depend on node labels, so colors are comparable across graphs.
+class Refinement {
+public:
+    // Refines both graphs with one shared numbering; returns false as soon
+    // as the color histograms differ (the graphs cannot be isomorphic
+    // under the given coloring)
+    static bool refine(const CSRGraph& graphA, Colors& colorsA, const CSRGraph& graphB, Colors& colorsB);
+
+    // Refines a single graph; returns the number of colors
+    static int refine(const CSRGraph& graph, Colors& colors);
+
+    // Number of colors, assuming colors are numbered 0..k-1
+    static int count(const Colors& colors);
+};
+
+} // namespace Graph
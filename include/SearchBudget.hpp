@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+namespace Graph {
+
+// Limits shared by everything searching for one answer: a number of search
+// tree nodes, a wall-clock deadline and an external cancellation flag
+// (0 / nullptr = unlimited). spend() and halt() may be called from several
+// threads at once.
+class SearchBudget {
+public:
+    SearchBudget() = default;
+    SearchBudget(std::size_t nodeLimit, std::chrono::milliseconds timeLimit, const std::atomic<bool>* cancel);
+    // At most nodeLimit nodes of the parent's budget; stops with the parent.
+    // Running out or halting does not stop the parent.
+    SearchBudget(std::size_t nodeLimit, SearchBudget& parent);
+
+    // Counts one search tree node; false once the search has to stop
+    bool spend();
+
+    // Stops every search sharing the budget without marking it exhausted
+    // (e.g. another thread already found the answer)
+    void halt();
+
+    bool stopped() const;
+    // True if a limit or the cancellation flag ended the search
+    bool exhausted() const;
+
+    std::size_t spent() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::size_t nodeLimit = 0;
+    bool timed = false;
+    Clock::time_point deadline;
+    const std::atomic<bool>* cancel = nullptr;
+    SearchBudget* parent = nullptr;
+
+    std::atomic<std::size_t> nodes{0};
+    std::atomic<bool> halted{false};
+    std::atomic<bool> ranOut{false};
+
+    void exhaust();
+};
+
+} // namespace Graph
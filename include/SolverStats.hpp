@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Solver statistics are only collected when built with -DGRAPH_STATS
+// (make STATS=1); otherwise the hooks below compile to nothing.
+#ifdef GRAPH_STATS
+#define GRAPH_STAT(...) do { __VA_ARGS__; } while (0)
+#else
+#define GRAPH_STAT(...) do {} while (0)
+#endif
+
+namespace Graph {
+
+struct SolverStats {
+    static constexpr bool enabled =
+#ifdef GRAPH_STATS
+        true;
+#else
+        false;
+#endif
+
+    // Phase timings in nanoseconds: feature generation (0 for prepared
+    // graphs), partition/order setup, and the search itself
+    std::uint64_t featureNanos = 0;
+    std::uint64_t setupNanos = 0;
+    std::uint64_t searchNanos = 0;
+
+    // Search tree nodes, for every engine
+    std::size_t nodes = 0;
+
+    // Group engine only
+    std::size_t subMappingChecks = 0;
+    std::size_t backtracks = 0;     // positions whose candidates all failed
+    std::size_t pruned = 0;         // candidates skipped as orbit-equivalent
+    int maxDepth = 0;               // deepest position reached
+    std::size_t groups = 0;
+    std::size_t largestGroup = 0;
+    std::size_t searchBytes = 0;    // group lists, index, order and frame stacks
+
+    // Adds counters and timings, keeps the larger maxima
+    void merge(const SolverStats& other);
+};
+
+// Adds its own lifetime to *nanos (if not null) when stats are compiled in
+class StatTimer {
+public:
+#ifdef GRAPH_STATS
+    explicit StatTimer(std::uint64_t* nanos) : nanos(nanos), start(Clock::now()) {}
+
+    ~StatTimer() {
+        if (nanos)
+            *nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::uint64_t* nanos;
+    Clock::time_point start;
+#else
+    explicit StatTimer(std::uint64_t*) {}
+#endif
+
+public:
+    StatTimer(const StatTimer&) = delete;
+    StatTimer& operator=(const StatTimer&) = delete;
+};
+
+} // namespace Graph
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads. The calling thread takes part in run()
+// as worker 0, so a pool of size 1 spawns no threads at all.
+class ThreadPool {
+public:
+    using Task = std::function<void(int worker, int index)>;
+
+    // workers <= 0 selects std::thread::hardware_concurrency()
+    explicit ThreadPool(int workers = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Calls task(worker, index) for every index in [0, count) and blocks until
+    // all calls return; the first exception thrown by a task is rethrown here
+    void run(int count, const Task& task);
+
+    int size() const;
+
+private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+
+    const Task* task = nullptr;
+    int count = 0;
+    std::atomic<int> next{0};
+    int generation = 0;
+    int busy = 0;
+    bool stopping = false;
+    std::exception_ptr error;
+
+    void loop(int worker);
+    void work(int worker);
+};
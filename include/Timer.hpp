@@ -1,22 +1,85 @@
 #pragma once
 
-#include <string>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
 
 class Timer {
 public:
+    using Clock = std::chrono::steady_clock;
+
     void start();
     void stop();
-    std::string get() const;
+    std::uint64_t nanos() const;  // elapsed time, up to now while running
+    std::string get() const;      // HH:MM:SS.mmm
     void print() const;
 
     static std::string now();
 
 private:
-    using Clock     = std::chrono::high_resolution_clock;
     using TimePoint = Clock::time_point;
 
     bool running = false;
     TimePoint startTime;
     TimePoint endTime;
-};
\ No newline at end of file
+};
+
+// Scoped phase profiler. While enabled, each Scope adds its lifetime to a
+// phase named by the path of scopes open on the same thread ("a/b/c"), so
+// nested phases aggregate under their parents. Every thread accumulates
+// into its own log; report() sums the logs by path. Disabled scopes cost
+// one relaxed atomic load.
+class Profiler {
+    struct Log;
+    struct Registry;
+
+public:
+    // name must outlive the profiler data (normally a string literal)
+    class Scope {
+    public:
+        explicit Scope(const char* name);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Log* log = nullptr;
+        const char* name = nullptr;
+        Timer timer;
+        std::uint64_t begin = 0;
+    };
+
+    struct Phase {
+        std::string path;
+        std::uint64_t calls = 0;
+        std::uint64_t nanos = 0;
+        int threads = 0;  // threads that entered the phase
+    };
+
+    static void enable(bool on = true);
+    static bool enabled();
+
+    // Drops everything recorded so far and restarts the trace clock
+    static void reset();
+
+    // Phases summed over threads, sorted by path
+    static std::vector<Phase> report();
+
+    // {"phases": [{"path", "calls", "nanos", "threads"}, ...]}
+    static void writeJSON(std::ostream& out);
+
+    // Chrome trace event format (chrome://tracing, Perfetto): one complete
+    // event per scope, timestamps in microseconds since the last reset()
+    static void writeTrace(std::ostream& out);
+
+private:
+    static std::atomic<bool> active;
+
+    static Registry& registry();
+    static Log& threadLog();
+    static std::uint64_t elapsed();  // nanoseconds since the last reset()
+};
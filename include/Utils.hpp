@@ -10,6 +10,7 @@
 #include <map>
 #include <algorithm>
 #include <filesystem>
+#include <cstdint>
 
 namespace Utils {
 
@@ -61,6 +62,19 @@ inline bool common(const Container1& a, const Container2& b) {
     return false;
 }
 
+// Scrambles a 64-bit value (splitmix64 finalizer)
+inline uint64_t mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Folds value into an order-dependent running hash
+inline uint64_t hashCombine(uint64_t seed, uint64_t value) {
+    return mix(seed ^ (mix(value) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+}
+
 // Extracts filename stem from path
 inline std::string getBasename(const std::string& pathStr) {
     fs::path path(pathStr);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vector>
+#include "CSRGraph.hpp"
+#include "Refinement.hpp"
+#include "SearchBudget.hpp"
+
+namespace Graph {
+
+// VF2++ style state-space matcher. Nodes of graphA are matched one at a time
+// in a BFS order that prefers rare colors and nodes tightly connected to the
+// already ordered ones; each candidate pair must agree on color, degrees and
+// edges to matched nodes, and on how many of their neighbors fall into each
+// terminal set (look-ahead cardinality pruning).
+class VF2 {
+public:
+    // colorsA/colorsB: node labels shared across both graphs (e.g. the
+    // feature partition). On success maps[i] is the graphB node matched to
+    // node i of graphA. With a budget, false may also mean it ran out.
+    static bool match(
+        const CSRGraph& graphA, const CSRGraph& graphB,
+        const Colors& colorsA, const Colors& colorsB,
+        std::vector<int>& maps,
+        SearchBudget* budget = nullptr
+    );
+
+private:
+    struct State;
+
+    static std::vector<int> order(const CSRGraph& graph, const Colors& colors);
+};
+
+} // namespace Graph
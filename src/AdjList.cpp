@@ -1,6 +1,7 @@
 #include "AdjList.hpp"
 #include <vector>
 #include <algorithm>
+#include "Timer.hpp"
 
 namespace Graph {
 
@@ -41,6 +42,7 @@ void AdjList::erase(int node) {
 }
 
 void AdjList::loadCSV(const std::string& filepath) {
+    Profiler::Scope scope("loadCSV");
     for (const auto& data : Utils::loadCSV(filepath)) {
         if (data.size() != 2) {
             std::cerr << "[Warning] Invalid file: " << filepath << std::endl;
@@ -0,0 +1,139 @@
+#include "CSRGraph.hpp"
+#include <algorithm>
+#include "Timer.hpp"
+
+namespace Graph {
+
+// --- Private ---
+void CSRGraph::build(std::vector<Edge> edges, std::vector<int> nodes) {
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    ids = std::move(nodes);
+    ids.reserve(ids.size() + edges.size() * 2);
+    for (const auto& [src, dst] : edges) {
+        ids.push_back(src);
+        ids.push_back(dst);
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    ids.shrink_to_fit();
+
+    for (auto& [src, dst] : edges) {
+        src = index(src);
+        dst = index(dst);
+    }
+
+    const std::size_t n = ids.size();
+    outOffsets.assign(n + 1, 0);
+    inOffsets.assign(n + 1, 0);
+    for (const auto& [src, dst] : edges) {
+        ++outOffsets[src + 1];
+        ++inOffsets[dst + 1];
+    }
+    for (std::size_t i = 1; i <= n; ++i) {
+        outOffsets[i] += outOffsets[i - 1];
+        inOffsets[i] += inOffsets[i - 1];
+    }
+
+    // Edges are sorted by (src, dst), so both arrays come out sorted per node
+    outEdges.resize(edges.size());
+    inEdges.resize(edges.size());
+    std::vector<std::size_t> inPos(inOffsets.begin(), inOffsets.end() - 1);
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+        const auto& [src, dst] = edges[i];
+        outEdges[i] = dst;
+        inEdges[inPos[dst]++] = src;
+    }
+}
+
+// --- Construction ---
+CSRGraph::CSRGraph(const AdjList& adj) {
+    std::vector<Edge> edges;
+    for (const auto& [src, dsts] : adj)
+        for (int dst : dsts)
+            edges.emplace_back(src, dst);
+
+    // Nodes without edges (e.g. created by adj[node]) are kept as well
+    const NodeSet& nodes = adj.getNodes();
+    build(std::move(edges), std::vector<int>(nodes.begin(), nodes.end()));
+}
+
+CSRGraph::CSRGraph(std::vector<Edge> edges) {
+    build(std::move(edges));
+}
+
+CSRGraph CSRGraph::loadCSV(const std::string& filepath) {
+    Profiler::Scope scope("loadCSV");
+    std::vector<Edge> edges;
+    for (const auto& data : Utils::loadCSV(filepath)) {
+        if (data.size() != 2) {
+            std::cerr << "[Warning] Invalid file: " << filepath << std::endl;
+            continue;
+        }
+        edges.emplace_back(data[0], data[1]);
+    }
+    return CSRGraph(std::move(edges));
+}
+
+// --- ID translation ---
+int CSRGraph::id(int node) const {
+    return ids.at(node);
+}
+
+int CSRGraph::index(int id) const {
+    auto it = std::lower_bound(ids.begin(), ids.end(), id);
+    if (it == ids.end() || *it != id) return -1;
+    return static_cast<int>(it - ids.begin());
+}
+
+// --- Neighbor access ---
+NodeRange CSRGraph::out(int node) const {
+    const int* base = outEdges.data();
+    return {base + outOffsets[node], base + outOffsets[node + 1]};
+}
+
+NodeRange CSRGraph::in(int node) const {
+    const int* base = inEdges.data();
+    return {base + inOffsets[node], base + inOffsets[node + 1]};
+}
+
+int CSRGraph::outDegree(int node) const {
+    return static_cast<int>(outOffsets[node + 1] - outOffsets[node]);
+}
+
+int CSRGraph::inDegree(int node) const {
+    return static_cast<int>(inOffsets[node + 1] - inOffsets[node]);
+}
+
+// --- Edge presence checks ---
+bool CSRGraph::hasEdge(int src, int dst) const {
+    const NodeRange dsts = out(src);
+    return std::binary_search(dsts.begin(), dsts.end(), dst);
+}
+
+// --- Information access ---
+const std::vector<int>& CSRGraph::getIds() const {
+    return ids;
+}
+
+std::size_t CSRGraph::size() const {
+    return ids.size();
+}
+
+std::size_t CSRGraph::edgeCount() const {
+    return outEdges.size();
+}
+
+std::size_t CSRGraph::bytes() const {
+    return sizeof(*this)
+        + ids.capacity() * sizeof(int)
+        + (outOffsets.capacity() + inOffsets.capacity()) * sizeof(std::size_t)
+        + (outEdges.capacity() + inEdges.capacity()) * sizeof(int);
+}
+
+bool CSRGraph::empty() const {
+    return ids.empty();
+}
+
+} // namespace Graph
@@ -0,0 +1,286 @@
+#include "Canonical.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+#include "Timer.hpp"
+
+namespace Graph {
+
+// Individualization-refinement search for the canonical leaf: the one with
+// the smallest trace (a node invariant per level of its path), and among
+// those the smallest relabeled edge list.
+//
+// - A tree node whose trace prefix is already larger than the best leaf's
+//   cannot lead to the canonical leaf and is skipped.
+// - A leaf equal to the best one yields an automorphism mapping its path
+//   onto the best path, so the subtree below the level where the two paths
+//   split mirrors an explored one; the search jumps back to that level.
+// - At each tree node, candidates in the same orbit as an explored one
+//   (under the automorphisms that fix the current path) are skipped. The
+//   orbits are kept per frame and only extended with new automorphisms.
+//
+// With firstLeaf set the search only collects automorphisms: the first leaf
+// stays the reference and any tree node whose trace departs from its trace
+// is skipped, since it cannot lead to an equal leaf.
+struct Canonical::Search {
+    const CSRGraph& graph;
+    const int n;
+    SearchBudget* budget;
+    bool firstLeaf = false;
+    std::size_t maxNodes = 0;  // 0 = unlimited; reaching it is not an abort
+
+    Colors best;
+    std::vector<Edge> bestEdges;
+    std::vector<int> bestPath;
+    std::vector<uint64_t> bestTrace;
+    std::vector<std::vector<int>> automorphisms;
+    bool aborted = false;
+
+    // One frame per tree node on the current path; the arena only grows, so
+    // frames keep their buffers between visits
+    struct Frame {
+        Colors colors;
+        int target;              // color of the cell being individualized
+        int next;                // next node to consider
+        int node;                // node individualized for the current child
+        int order;               // trace vs best trace so far: -1 smaller, 0 equal
+        std::vector<int> parent; // orbit union-find
+        std::vector<char> explored;  // by orbit root
+        std::vector<int> tried;
+        std::size_t applied;     // automorphisms already merged into parent
+    };
+
+    std::vector<Frame> frames;
+    std::vector<uint64_t> trace;
+    int depth = 0;
+
+    Search(const CSRGraph& graph, SearchBudget* budget)
+        : graph(graph), n(static_cast<int>(graph.size())), budget(budget) {}
+
+    // Cell count and sizes in color order; colors are numbered independently
+    // of node labels, so this is an isomorphism invariant of the tree node
+    uint64_t invariant(const Colors& colors) const {
+        const int count = Refinement::count(colors);
+        std::vector<int> cellSize(count, 0);
+        for (int c : colors) ++cellSize[c];
+
+        uint64_t hash = count;
+        for (int size : cellSize)
+            hash = Utils::hashCombine(hash, size);
+        return hash;
+    }
+
+    // Pushes the tree node for colors, or handles it as a leaf. Returns the
+    // level to resume at: depth - 1 normally, less after an automorphism.
+    int enter(const Colors& colors, int order) {
+        const uint64_t value = invariant(colors);
+        const int level = depth;
+        if (firstLeaf && !best.empty()) {
+            if (level >= (int)bestTrace.size() || value != bestTrace[level])
+                return level - 1;
+        } else if (order == 0 && !best.empty()) {
+            if (level >= (int)bestTrace.size() || value > bestTrace[level])
+                return level - 1;
+            if (value < bestTrace[level])
+                order = -1;
+        }
+        trace.resize(level);
+        trace.push_back(value);
+
+        const int count = Refinement::count(colors);
+        std::vector<int> cellSize(count, 0);
+        for (int c : colors) ++cellSize[c];
+
+        int target = -1;
+        for (int c = 0; c < count; ++c)
+            if (cellSize[c] > 1 && (target == -1 || cellSize[c] < cellSize[target]))
+                target = c;
+
+        if (target == -1)
+            return leaf(colors, order);
+
+        if ((int)frames.size() <= level)
+            frames.emplace_back();
+        Frame& f = frames[level];
+        f.colors = colors;
+        f.target = target;
+        f.next = 0;
+        f.node = -1;
+        f.order = order;
+        f.parent.resize(n);
+        std::iota(f.parent.begin(), f.parent.end(), 0);
+        f.explored.assign(n, 0);
+        f.tried.clear();
+        f.applied = automorphisms.size();
+        depth = level + 1;
+        return level;
+    }
+
+    int leaf(const Colors& colors, int order) {
+        const int level = depth;
+        std::vector<Edge> edges;
+        edges.reserve(graph.edgeCount());
+        for (int src = 0; src < n; ++src)
+            for (int dst : graph.out(src))
+                edges.emplace_back(colors[src], colors[dst]);
+        std::sort(edges.begin(), edges.end());
+
+        if (best.empty() || (!firstLeaf && (order < 0 || edges < bestEdges))) {
+            best = colors;
+            bestEdges = std::move(edges);
+            bestTrace = trace;
+            bestPath.clear();
+            for (int i = 0; i < level; ++i) {
+                bestPath.push_back(frames[i].node);
+                frames[i].order = 0;
+            }
+            return level - 1;
+        }
+        if (edges != bestEdges)
+            return level - 1;
+
+        // Same relabeled graph: node -> best node with the same label
+        std::vector<int> bestNode(n), automorphism(n);
+        for (int node = 0; node < n; ++node)
+            bestNode[best[node]] = node;
+        for (int node = 0; node < n; ++node)
+            automorphism[node] = bestNode[colors[node]];
+        automorphisms.push_back(std::move(automorphism));
+
+        int split = 0;
+        while (split < level && frames[split].node == bestPath[split])
+            ++split;
+        return split;
+    }
+
+    static int find(std::vector<int>& parent, int x) {
+        while (parent[x] != x) x = parent[x] = parent[parent[x]];
+        return x;
+    }
+
+    // Merges the automorphisms found since the frame was last visited that
+    // fix the path above it, then re-marks the explored orbits
+    void updateOrbits(Frame& f, int level) {
+        if (f.applied == automorphisms.size()) return;
+        for (; f.applied < automorphisms.size(); ++f.applied) {
+            const auto& automorphism = automorphisms[f.applied];
+            bool fixesPath = true;
+            for (int i = 0; i < level && fixesPath; ++i)
+                fixesPath = automorphism[frames[i].node] == frames[i].node;
+            if (!fixesPath) continue;
+            for (int x = 0; x < n; ++x)
+                f.parent[find(f.parent, x)] = find(f.parent, automorphism[x]);
+        }
+        std::fill(f.explored.begin(), f.explored.end(), 0);
+        for (int node : f.tried)
+            f.explored[find(f.parent, node)] = 1;
+    }
+
+    void run(const Colors& colors) {
+        int level = enter(colors, 0);
+        Colors next;
+
+        for (std::size_t nodes = 1; level >= 0; ++nodes) {
+            if (budget && !budget->spend()) {
+                aborted = true;
+                return;
+            }
+            if (maxNodes && nodes > maxNodes)
+                return;
+
+            depth = level + 1;
+            Frame& f = frames[level];
+            updateOrbits(f, level);
+
+            int node = -1;
+            while (f.next < n) {
+                const int v = f.next++;
+                if (f.colors[v] == f.target && !f.explored[find(f.parent, v)]) {
+                    node = v;
+                    break;
+                }
+            }
+            if (node == -1) {
+                --level;
+                continue;
+            }
+
+            f.node = node;
+            f.tried.push_back(node);
+            f.explored[find(f.parent, node)] = 1;
+
+            next = f.colors;
+            next[node] = Refinement::count(f.colors);
+            Refinement::refine(graph, next);
+
+            depth = level + 1;
+            level = enter(next, f.order);
+        }
+    }
+};
+
+// Fingerprint order does not depend on node labels, so it seeds the colors
+static Colors seedColors(const CSRGraph& graph, const std::map<FeatPrint, NodeSet>& feat) {
+    Colors colors(graph.size());
+    int color = 0;
+    for (const auto& [_, nodes] : feat) {
+        for (int n : nodes) colors[n] = color;
+        ++color;
+    }
+    Refinement::refine(graph, colors);
+    return colors;
+}
+
+CanonicalForm Canonical::label(const AdjList& adj, SearchBudget* budget) {
+    return label(CSRGraph(adj), budget);
+}
+
+CanonicalForm Canonical::label(const CSRGraph& graph, SearchBudget* budget, int threads) {
+    return label(graph, Feature::genPrint(graph, threads), budget);
+}
+
+CanonicalForm Canonical::label(const PreparedGraph& graph, SearchBudget* budget) {
+    return label(graph.getGraph(), graph.getFeatures(), budget);
+}
+
+CanonicalForm Canonical::label(const CSRGraph& graph, const std::map<FeatPrint, NodeSet>& feat, SearchBudget* budget) {
+    Profiler::Scope scope("Canonical::label");
+    Search search(graph, budget);
+    search.run(seedColors(graph, feat));
+
+    CanonicalForm form;
+    form.automorphisms = std::move(search.automorphisms);
+    if (search.aborted) {
+        form.complete = false;
+        return form;
+    }
+    form.labeling = std::move(search.best);
+    form.edges = std::move(search.bestEdges);
+
+    uint64_t low = graph.size(), high = ~static_cast<uint64_t>(graph.edgeCount());
+    for (const auto& [src, dst] : form.edges) {
+        low = Utils::hashCombine(Utils::hashCombine(low, src), dst);
+        high = Utils::hashCombine(Utils::hashCombine(high, dst), src);
+    }
+
+    std::ostringstream oss;
+    oss << graph.size() << ":" << graph.edgeCount() << ":" << std::hex << std::setfill('0')
+        << std::setw(16) << high << std::setw(16) << low;
+    form.certificate = oss.str();
+
+    return form;
+}
+
+std::vector<std::vector<int>> Canonical::automorphisms(
+    const CSRGraph& graph, const std::map<FeatPrint, NodeSet>& feat, SearchBudget* budget, std::size_t maxNodes
+) {
+    Profiler::Scope scope("Canonical::automorphisms");
+    Search search(graph, budget);
+    search.firstLeaf = true;
+    search.maxNodes = maxNodes;
+    search.run(seedColors(graph, feat));
+    return std::move(search.automorphisms);
+}
+
+} // namespace Graph
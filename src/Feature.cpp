@@ -1,223 +1,743 @@
 #include "Feature.hpp"
-#include <queue>
+#include <cstdint>
+#include <stdexcept>
 #include <vector>
 #include <algorithm>
+#include <limits>
+#include <memory>
+#include "ThreadPool.hpp"
+#include "Timer.hpp"
 
 namespace Graph {
 
 std::map<FeatSig, NodeSet> Feature::gen(const AdjList& adj) {
-    const NodeSet nodes = adj.getNodes();
-    const AdjList rev = adj.getReversed();
+    const CSRGraph graph(adj);
 
-    std::map<Degs, NodeSet> degToNodes;
-    for (int n : nodes)
-        degToNodes[{(int)adj[n].size(), (int)rev[n].size()}].insert(n);
+    std::map<FeatSig, NodeSet> featToNodes;
+    for (auto& [feat, nodes] : gen(graph)) {
+        NodeSet& ids = featToNodes[feat];
+        for (int n : nodes)
+            ids.insert(graph.id(n));
+    }
+    return featToNodes;
+}
 
-    std::unordered_map<int, FeatSig> nodeToFeat;
-    for (const auto& [deg, dNodes] : degToNodes) {
-        for (int n : dNodes) {
-            auto state = genFeatState(n, nodes, adj, rev);
-            for (const auto& [dst, dset] : state)
-                nodeToFeat[dst][deg].insert(dset);
+// Bit-parallel BFS from up to 64 sources at once; bit j of every word
+// belongs to source j. Matches the signed-distance walk of a FIFO state queue:
+// a node is expanded at the first level it is reached, forward once, and
+// backward once per reverse arrival if it was also reached forward at that
+// level (once otherwise). Every edge out of an expanded state adds its signed
+// distance to the target's set. Reverse multiplicities and per-node arrival
+// counts are kept as bit-sliced counters, so each edge costs a few word ops.
+class BitBFS {
+public:
+    static constexpr int Lanes = 64;
+
+    explicit BitBFS(const CSRGraph& graph)
+        : graph(graph), n(static_cast<int>(graph.size())),
+          visited(n), fwd(n), nextFwd(n),
+          rev(n * CounterBits), nextRev(n * CounterBits),
+          dists(Lanes * n) {}
+
+    // Runs sources first..first+lanes-1 and fills dist(lane, node)
+    void run(int first, int lanes) {
+        for (auto& d : dists) d.clear();
+        std::fill(visited.begin(), visited.end(), 0);
+        std::fill(fwd.begin(), fwd.end(), 0);
+        std::fill(rev.begin(), rev.end(), 0);
+        std::fill(nextRev.begin(), nextRev.end(), 0);
+        width = 1;
+
+        for (int lane = 0; lane < lanes; ++lane) {
+            const int src = first + lane;
+            visited[src] = fwd[src] = rev[src * CounterBits] = bit(lane);
+            dists[lane * n + src].push_back(0);
+        }
+
+        bool active = true;
+        for (int level = 1; active; ++level) {
+            active = false;
+            for (int dst = 0; dst < n; ++dst) {
+                uint64_t fCount[CounterBits] = {}, rCount[CounterBits] = {};
+                int fWidth = 0, rWidth = 0;
+                uint64_t fAny = 0, rAny = 0;
+
+                for (int src : graph.in(dst)) {
+                    add(fCount, fWidth, &fwd[src], 1);
+                    fAny |= fwd[src];
+                }
+                for (int src : graph.out(dst))
+                    add(rCount, rWidth, &rev[src * CounterBits], width);
+                for (int b = 0; b < rWidth; ++b)
+                    rAny |= rCount[b];
+
+                record(fCount, fWidth, fAny, dst, level);
+                record(rCount, rWidth, rAny, dst, -level);
+
+                const uint64_t newFwd = fAny & ~visited[dst];
+                const uint64_t newRev = rAny & ~visited[dst];
+                visited[dst] |= newFwd | newRev;
+                active |= (newFwd | newRev) != 0;
+
+                nextFwd[dst] = newFwd;
+                uint64_t* next = &nextRev[dst * CounterBits];
+                const int nextWidth = std::max(width, rWidth);
+                for (int b = 0; b < nextWidth; ++b)
+                    next[b] = rCount[b] & newRev & fAny;
+                next[0] |= newRev & ~fAny;
+                width = nextWidth;
+            }
+            fwd.swap(nextFwd);
+            rev.swap(nextRev);
         }
     }
 
+    const std::vector<int>& dist(int lane, int node) const {
+        return dists[lane * n + node];
+    }
+
+private:
+    static constexpr int CounterBits = 32;
+
+    const CSRGraph& graph;
+    const int n;
+    int width = 1;
+    std::vector<uint64_t> visited, fwd, nextFwd, rev, nextRev;
+    std::vector<std::vector<int>> dists;
+
+    static uint64_t bit(int lane) { return uint64_t{1} << lane; }
+
+    // Adds the bit-sliced value (valueWidth slices) into counter lane-wise
+    static void add(uint64_t* counter, int& counterWidth, const uint64_t* value, int valueWidth) {
+        uint64_t carry = 0;
+        for (int b = 0; b < valueWidth || carry; ++b) {
+            if (b == CounterBits)
+                throw std::overflow_error("[Feature] Distance multiplicity overflow");
+            const uint64_t v = b < valueWidth ? value[b] : 0;
+            const uint64_t sum = counter[b] ^ v ^ carry;
+            carry = (counter[b] & v) | (carry & (counter[b] ^ v));
+            counter[b] = sum;
+            if (sum) counterWidth = std::max(counterWidth, b + 1);
+        }
+    }
+
+    void record(const uint64_t* counter, int counterWidth, uint64_t lanes, int dst, int dist) {
+        for (; lanes; lanes &= lanes - 1) {
+            const int lane = __builtin_ctzll(lanes);
+            int count = 0;
+            for (int b = 0; b < counterWidth; ++b)
+                count |= static_cast<int>((counter[b] >> lane) & 1) << b;
+            auto& d = dists[lane * n + dst];
+            d.insert(d.end(), count, dist);
+        }
+    }
+};
+
+// Runs every 64-source batch of graph on pool; each worker keeps its BFS
+// buffers across batches. visit(worker, bfs, first, lanes) reads the results.
+template <typename Visit>
+static void runBatches(const CSRGraph& graph, ThreadPool& pool, Visit visit) {
+    const int n = static_cast<int>(graph.size());
+    const int batches = (n + BitBFS::Lanes - 1) / BitBFS::Lanes;
+    std::vector<std::unique_ptr<BitBFS>> scratch(pool.size());
+
+    pool.run(batches, [&](int worker, int batch) {
+        if (!scratch[worker])
+            scratch[worker] = std::make_unique<BitBFS>(graph);
+
+        const int first = batch * BitBFS::Lanes;
+        const int lanes = std::min(BitBFS::Lanes, n - first);
+        scratch[worker]->run(first, lanes);
+        visit(worker, *scratch[worker], first, lanes);
+    });
+}
+
+static int poolSize(const CSRGraph& graph, int threads) {
+    const int batches = (static_cast<int>(graph.size()) + BitBFS::Lanes - 1) / BitBFS::Lanes;
+    return threads > 0 ? std::min(threads, std::max(batches, 1)) : threads;
+}
+
+std::map<FeatSig, NodeSet> Feature::gen(const CSRGraph& graph, int threads) {
+    Profiler::Scope scope("Feature::gen");
+    const int n = static_cast<int>(graph.size());
+    ThreadPool pool(poolSize(graph, threads));
+
+    std::vector<std::vector<FeatSig>> partial(pool.size());
+    runBatches(graph, pool, [&](int worker, const BitBFS& bfs, int first, int lanes) {
+        std::vector<FeatSig>& nodeToFeat = partial[worker];
+        if (nodeToFeat.empty())
+            nodeToFeat.resize(n);
+
+        for (int lane = 0; lane < lanes; ++lane) {
+            const Degs deg = {graph.outDegree(first + lane), graph.inDegree(first + lane)};
+            for (int dst = 0; dst < n; ++dst) {
+                const auto& dist = bfs.dist(lane, dst);
+                if (!dist.empty())
+                    nodeToFeat[dst][deg].emplace(dist.begin(), dist.end());
+            }
+        }
+    });
+
+    // Merge per node in worker order; multiset contents do not depend on
+    // which worker produced an entry, so the result is deterministic
+    std::vector<FeatSig> nodeToFeat(n);
+    pool.run(n, [&](int, int node) {
+        for (auto& feats : partial) {
+            if (feats.empty()) continue;
+            for (auto& [deg, dsets] : feats[node])
+                nodeToFeat[node][deg].merge(dsets);
+        }
+    });
+    partial.clear();
+
     std::map<FeatSig, NodeSet> featToNodes;
-    for (const auto& [n, feat] : nodeToFeat)
-        featToNodes[feat].insert(n);
+    for (int node = 0; node < n; ++node)
+        featToNodes[nodeToFeat[node]].insert(node);
 
     return featToNodes;
 }
 
-struct VectorHash {
-    size_t operator()(const std::vector<int>& v) const {
-        size_t seed = v.size();
-        for (int i : v)
-            seed ^= std::hash<int>{}(i) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-        return seed;
+std::map<FeatPrint, NodeSet> Feature::genPrint(const CSRGraph& graph, int threads) {
+    Profiler::Scope scope("Feature::genPrint");
+    const int n = static_cast<int>(graph.size());
+    ThreadPool pool(poolSize(graph, threads));
+
+    // BitBFS records a node's distances level by level (forward before
+    // reverse), which is already a canonical order for the multiset
+    std::vector<std::vector<std::vector<uint64_t>>> partial(pool.size());
+    runBatches(graph, pool, [&](int worker, const BitBFS& bfs, int first, int lanes) {
+        auto& nodeToEntries = partial[worker];
+        if (nodeToEntries.empty())
+            nodeToEntries.resize(n);
+
+        for (int lane = 0; lane < lanes; ++lane) {
+            const uint64_t deg = Utils::hashCombine(graph.outDegree(first + lane), graph.inDegree(first + lane));
+            for (int dst = 0; dst < n; ++dst) {
+                const auto& dist = bfs.dist(lane, dst);
+                if (dist.empty()) continue;
+
+                uint64_t entry = deg;
+                for (int d : dist)
+                    entry = Utils::hashCombine(entry, static_cast<uint64_t>(static_cast<int64_t>(d)));
+                nodeToEntries[dst].push_back(entry);
+            }
+        }
+    });
+
+    std::vector<FeatPrint> prints(n);
+    pool.run(n, [&](int, int node) {
+        std::vector<uint64_t>& sig = prints[node].sig;
+        for (auto& nodeToEntries : partial) {
+            if (nodeToEntries.empty()) continue;
+            auto& entries = nodeToEntries[node];
+            sig.insert(sig.end(), entries.begin(), entries.end());
+            std::vector<uint64_t>().swap(entries);
+        }
+        std::sort(sig.begin(), sig.end());
+
+        uint64_t hash = sig.size();
+        for (uint64_t entry : sig)
+            hash = Utils::hashCombine(hash, entry);
+        prints[node].hash = hash;
+    });
+    partial.clear();
+
+    std::map<FeatPrint, NodeSet> printToNodes;
+    for (int node = 0; node < n; ++node) {
+        FeatPrint print = std::move(prints[node]);
+        printToNodes[std::move(print)].insert(node);
     }
-};
 
+    return printToNodes;
+}
+
+// Interns 64-bit label hashes as dense color ids in first-seen order:
+// open addressing with linear probing, kept at most half full. Labels that
+// collide on all 64 bits share a color.
 class Encoder {
+public:
+    int encode(uint64_t label) {
+        if (2 * (static_cast<std::size_t>(nextId) + 1) > keys.size())
+            grow();
+
+        const std::size_t mask = keys.size() - 1;
+        std::size_t slot = label & mask;
+        while (ids[slot] != -1) {
+            if (keys[slot] == label)
+                return ids[slot];
+            slot = (slot + 1) & mask;
+        }
+        keys[slot] = label;
+        ids[slot] = nextId;
+        order.push_back(label);
+        return nextId++;
+    }
+
+    int size() const { return nextId; }
+
+    // Interned labels by id
+    const std::vector<uint64_t>& labels() const { return order; }
+
 private:
-    std::unordered_map<std::string, int> table_;
-    int nextId_ = 0;
+    std::vector<uint64_t> keys;
+    std::vector<int> ids;
+    std::vector<uint64_t> order;
+    int nextId = 0;
+
+    void grow() {
+        std::vector<uint64_t> oldKeys(std::max<std::size_t>(16, keys.size() * 2));
+        std::vector<int> oldIds(oldKeys.size(), -1);
+        keys.swap(oldKeys);
+        ids.swap(oldIds);
+
+        const std::size_t mask = keys.size() - 1;
+        for (std::size_t i = 0; i < oldKeys.size(); ++i) {
+            if (oldIds[i] == -1) continue;
+            std::size_t slot = oldKeys[i] & mask;
+            while (ids[slot] != -1)
+                slot = (slot + 1) & mask;
+            keys[slot] = oldKeys[i];
+            ids[slot] = oldIds[i];
+        }
+    }
+};
 
+// 要素 [0, total) のラベルを並列に番号付けする。label() は index の連続区間
+// (チャンク) ごとにラベルをチャンク内で番号付けし、merge() はチャンク順に
+// 共有 Encoder へ統合し、remap() で大域番号に書き換える。番号は index 順の
+// 初出順になり、スレッド数に依存しない。
+class ChunkLabeler {
 public:
-    int encode(const std::string& label) {
-        auto [it, inserted] = table_.insert({label, nextId_});
-        if (inserted) ++nextId_;
-        return it->second;
+    // visit(worker, begin, end, encoder) は [begin, end) の各要素について
+    // out[index] = encoder.encode(ラベル) を書く
+    template <typename Visit>
+    void label(ThreadPool& pool, std::size_t total, Visit visit) {
+        this->total = total;
+        chunks = pool.size() == 1 ? 1 : static_cast<int>(std::min<std::size_t>(pool.size() * 8, total));
+        local.assign(chunks, Encoder());
+        pool.run(chunks, [&](int worker, int chunk) {
+            visit(worker, chunkBegin(chunk), chunkBegin(chunk + 1), local[chunk]);
+        });
+    }
+
+    void merge(Encoder& enc) {
+        remapTable.resize(chunks);
+        identity = true;
+        for (int chunk = 0; chunk < chunks; ++chunk) {
+            remapTable[chunk].clear();
+            for (uint64_t label : local[chunk].labels()) {
+                const uint32_t id = enc.encode(label);
+                identity &= id == remapTable[chunk].size();
+                remapTable[chunk].push_back(id);
+            }
+        }
+    }
+
+    void remap(ThreadPool& pool, std::vector<uint32_t>& out) const {
+        if (identity) return;
+        pool.run(chunks, [&](int, int chunk) {
+            const std::vector<uint32_t>& table = remapTable[chunk];
+            for (std::size_t index = chunkBegin(chunk); index < chunkBegin(chunk + 1); ++index)
+                out[index] = table[out[index]];
+        });
     }
 
-    int size() const { return nextId_; }
+private:
+    std::size_t total = 0;
+    int chunks = 1;
+    std::vector<Encoder> local;
+    std::vector<std::vector<uint32_t>> remapTable;
+    bool identity = true;
+
+    std::size_t chunkBegin(int chunk) const {
+        return total / chunks * chunk + std::min<std::size_t>(chunk, total % chunks);
+    }
 };
 
-std::vector<std::vector<int>> Feature::genTuples(const NodeSet& nodes, int k) {
-    std::vector<std::vector<int>> tuples;
-    std::vector<int> indices(k, 0);
-    std::vector<int> tuple(k);
-    std::vector<int> nodeVec(nodes.begin(), nodes.end());
-    int n = nodeVec.size();
+// タプルの色の共通部分: 現在の色 / 次の色の 2 本の配列と、1 ラウンドの
+// merge() → remap() → histogram() → advance()
+class TupleColors {
+public:
+    std::size_t size() const { return color.size(); }
+    const std::vector<uint32_t>& colors() const { return color; }
+
+    void merge(Encoder& enc) { labeler.merge(enc); }
+    void remap(ThreadPool& pool) { labeler.remap(pool, next); }
+
+    // 次の色の色ごとのタプル数
+    std::vector<std::size_t> histogram(int colors) const {
+        std::vector<std::size_t> counts(colors, 0);
+        for (uint32_t c : next) ++counts[c];
+        return counts;
+    }
+
+    void advance() { color.swap(next); }
 
-    while (true) {
-        for (int i = 0; i < k; ++i)
-            tuple[i] = nodeVec[indices[i]];
-        tuples.push_back(tuple);
+protected:
+    std::vector<uint32_t> color, next;
+    ChunkLabeler labeler;
 
-        int pos = k - 1;
-        while (pos >= 0 && ++indices[pos] == n)
-            indices[pos--] = 0;
-        if (pos < 0) break;
+    void resize(std::size_t total) {
+        color.resize(total);
+        next.resize(total);
     }
-    return tuples;
-}
+};
 
-std::vector<int> Feature::genkWL(const AdjList& adj, int k, int maxIter) {
-    const NodeSet& nodes = adj.getNodes();
-    const AdjList& rev = adj.getReversed();
+// k-WL の 1 グラフ分の状態。ノードを 0..n-1 に振り直し、タプル
+// (S[0], ..., S[k-1]) は n 進 k 桁の index = Σ S[i]·n^(k-1-i) で表す。
+class TupleColoring : public TupleColors {
+public:
+    TupleColoring(const AdjList& adj, int k) : adj(adj), k(k) {
+        const NodeSet& nodes = adj.getNodes();
+        const AdjList rev = adj.getReversed();
+        nodeVec.assign(nodes.begin(), nodes.end());
+        n = static_cast<int>(nodeVec.size());
+
+        place.resize(k);
+        std::size_t total = 1;
+        for (int i = k - 1; i >= 0; --i) {
+            place[i] = total;
+            if (n && total > std::numeric_limits<std::size_t>::max() / n)
+                throw std::length_error("[Feature] Too many k-WL tuples");
+            total *= n;
+        }
 
-    std::vector<std::vector<int>> tuples = genTuples(nodes, k);
-    std::cout << "Generated " << tuples.size() << " tuples.\n";
+        std::unordered_map<int, int> dense;
+        for (int v = 0; v < n; ++v)
+            dense[nodeVec[v]] = v;
+
+        // 次数と、出辺・入辺の隣接ノード (重複なし)
+        degs.resize(n);
+        nbrs.resize(n);
+        for (int v = 0; v < n; ++v) {
+            const NodeSet& out = adj[nodeVec[v]];
+            const NodeSet& in = rev[nodeVec[v]];
+            degs[v] = {static_cast<int>(out.size()), static_cast<int>(in.size())};
+            for (int w : out) nbrs[v].push_back(dense.at(w));
+            for (int w : in) nbrs[v].push_back(dense.at(w));
+            std::sort(nbrs[v].begin(), nbrs[v].end());
+            nbrs[v].erase(std::unique(nbrs[v].begin(), nbrs[v].end()), nbrs[v].end());
+        }
 
-    // 初期ラベル生成
-    auto genLabelInit = [&](const std::vector<int>& S) -> std::string {
-        std::ostringstream oss;
-        for (int n : S)
-            oss << "(" << adj[n].size() << "," << rev[n].size() << ")-";
+        resize(total);
+    }
 
-        for (int i = 0; i < k; ++i)
-            for (int j = i + 1; j < k; ++j)
-                oss << (adj.hasEdge(S[i],S[j]) ? "T" : "F") << (rev.hasEdge(S[i],S[j]) ? "T" : "F") << "-";
+    // 全タプルのラベルを計算し、チャンク内の番号を next に書く
+    void label(ThreadPool& pool, bool init) {
+        scratch.resize(pool.size());
+        labeler.label(pool, size(), [&](int worker, std::size_t begin, std::size_t end, Encoder& enc) {
+            Scratch& own = scratch[worker];
+            own.S.resize(k);
+            for (int i = 0; i < k; ++i)
+                own.S[i] = static_cast<int>(begin / place[i] % n);
+
+            for (std::size_t index = begin; index < end; ++index) {
+                next[index] = enc.encode(init ? labelInit(own) : labelUpdate(index, own));
+                for (int pos = k - 1; pos >= 0 && ++own.S[pos] == n; --pos)
+                    own.S[pos] = 0;
+            }
+        });
+    }
 
-        return oss.str();
+private:
+    // ワーカーごとの作業領域: 現在のタプル S と署名用バッファ
+    struct Scratch {
+        std::vector<int> S;
+        std::vector<int> adjNodes;
+        std::vector<uint64_t> adjColors;
     };
 
-    // 更新ラベル生成
-    auto genLabelUpdate = [&](const std::vector<int>& S, const std::unordered_map<std::vector<int>, int, VectorHash>& color) -> std::string {
-        NodeSet adjNodes;
-        for (int n : S) {
-            const auto& out = adj[n];
-            const auto& in  = rev[n];
-            adjNodes.insert(out.begin(), out.end());
-            adjNodes.insert(in.begin(), in.end());
+    const AdjList& adj;
+    const int k;
+    int n = 0;
+    std::vector<int> nodeVec;
+    std::vector<std::size_t> place;
+    std::vector<Degs> degs;
+    std::vector<std::vector<int>> nbrs;
+    std::vector<Scratch> scratch;
+
+    // 初期ラベル: 各ノードの次数と、各ペア間の辺の向き
+    uint64_t labelInit(const Scratch& own) const {
+        const std::vector<int>& S = own.S;
+        uint64_t label = k;
+        for (int v : S)
+            label = Utils::hashCombine(Utils::hashCombine(label, degs[v].first), degs[v].second);
+
+        for (int i = 0; i < k; ++i) {
+            for (int j = i + 1; j < k; ++j) {
+                const int a = nodeVec[S[i]], b = nodeVec[S[j]];
+                label = Utils::hashCombine(label, (adj.hasEdge(a, b) ? 2 : 0) | (adj.hasEdge(b, a) ? 1 : 0));
+            }
         }
 
-        std::vector<std::string> adjColors;
-        adjColors.reserve(adjNodes.size());
+        return label;
+    }
 
-        std::vector<int> Sx = S;
-        std::vector<int> sig;
-        sig.reserve(k);
+    // 更新ラベル: 自身の色と、隣接ノード x ごとの置換タプルの色の組 (ソート済み)
+    uint64_t labelUpdate(std::size_t index, Scratch& own) const {
+        auto& [S, adjNodes, adjColors] = own;
 
+        adjNodes.clear();
+        for (int v : S)
+            adjNodes.insert(adjNodes.end(), nbrs[v].begin(), nbrs[v].end());
+        std::sort(adjNodes.begin(), adjNodes.end());
+        adjNodes.erase(std::unique(adjNodes.begin(), adjNodes.end()), adjNodes.end());
+
+        adjColors.clear();
         for (int x : adjNodes) {
-            sig.clear();
-            for (int i = 0; i < k; ++i) {
-                Sx[i] = x;
-                sig.push_back(color.at(Sx));
-                Sx[i] = S[i];
+            uint64_t sig = k;
+            for (int i = 0; i < k; ++i)
+                sig = Utils::hashCombine(sig, color[index - S[i] * place[i] + x * place[i]]);
+            adjColors.push_back(sig);
+        }
+        std::sort(adjColors.begin(), adjColors.end());
+
+        uint64_t label = Utils::hashCombine(adjColors.size(), color[index]);
+        for (uint64_t sig : adjColors)
+            label = Utils::hashCombine(label, sig);
+
+        return label;
+    }
+};
+
+// 局所 k-WL (δ-k-LWL) の 1 グラフ分の状態。対象は連結 k タプル (ノード
+// 集合が無向で連結なもの) だけで、S[i] を置き換える先も S[i] の隣接ノード
+// x に限る。タプル数・1 ラウンドの計算量はともに辺数に比例する (k と
+// 次数を定数とみなして)。タプルは n 進 k 桁のキーの昇順に並べて保持する。
+class LocalTupleColoring : public TupleColors {
+public:
+    LocalTupleColoring(const CSRGraph& graph, int k) : graph(graph), k(k), n(static_cast<int>(graph.size())) {
+        place.resize(k);
+        uint64_t radix = 1;
+        for (int i = k - 1; i >= 0; --i) {
+            place[i] = radix;
+            if (n && radix > std::numeric_limits<uint64_t>::max() / n)
+                throw std::length_error("[Feature] Too many local k-WL tuples");
+            radix *= n;
+        }
+
+        // 無向の隣接ノードと辺の向き (出辺 2 | 入辺 1)、自己ループは除く
+        nbrs.resize(n);
+        for (int v = 0; v < n; ++v) {
+            auto& list = nbrs[v];
+            for (int w : graph.out(v)) if (w != v) list.emplace_back(w, 2);
+            for (int w : graph.in(v)) if (w != v) list.emplace_back(w, 1);
+            std::sort(list.begin(), list.end());
+            std::size_t kept = 0;
+            for (std::size_t j = 0; j < list.size(); ++j) {
+                if (kept && list[kept - 1].first == list[j].first)
+                    list[kept - 1].second |= list[j].second;
+                else
+                    list[kept++] = list[j];
             }
-            adjColors.emplace_back("(" + Utils::join(sig, ",") + ")");
+            list.resize(kept);
         }
 
-        std::sort(adjColors.begin(), adjColors.end());
+        enumerate();
+        resize(keys.size());
+    }
 
-        std::ostringstream oss;
-        oss << color.at(S) << ":";
-        for (const auto& s : adjColors)
-            oss << s << ",";
+    std::size_t tupleCount() const { return keys.size(); }
+
+    void label(ThreadPool& pool, bool init) {
+        scratch.resize(pool.size());
+        labeler.label(pool, size(), [&](int worker, std::size_t begin, std::size_t end, Encoder& enc) {
+            Scratch& own = scratch[worker];
+            own.S.resize(k);
+            for (std::size_t index = begin; index < end; ++index) {
+                for (int i = 0; i < k; ++i)
+                    own.S[i] = static_cast<int>(keys[index] / place[i] % n);
+                next[index] = enc.encode(init ? labelInit(own) : labelUpdate(index, own));
+            }
+        });
+    }
 
-        return oss.str();
+private:
+    struct Scratch {
+        std::vector<int> S;
+        std::vector<uint64_t> sigs;
     };
 
-    std::unordered_map<std::vector<int>, int, VectorHash> color;
-    Encoder enc;
-    for (const auto& S : tuples)
-        color[S] = enc.encode(genLabelInit(S));
-
-    std::cout << "iter 0 : " << enc.size() << " colors\n";
+    const CSRGraph& graph;
+    const int k;
+    const int n;
+    std::vector<uint64_t> place;
+    std::vector<std::vector<std::pair<int, int>>> nbrs;
+    std::vector<uint64_t> keys;
+    std::vector<Scratch> scratch;
+
+    // 各要素が前の要素のどれかと同じか隣接するタプルを列挙し、その並べ替えを
+    // すべて加える (連結なノード集合はどれも BFS 順に並べればこの形になる)
+    void enumerate() {
+        std::vector<int> S(k), sorted(k);
+        auto emit = [&] {
+            sorted = S;
+            std::sort(sorted.begin(), sorted.end());
+            do {
+                uint64_t key = 0;
+                for (int i = 0; i < k; ++i)
+                    key += sorted[i] * place[i];
+                keys.push_back(key);
+            } while (std::next_permutation(sorted.begin(), sorted.end()));
+        };
+
+        auto extend = [&](auto& self, int pos) -> void {
+            if (pos == k) {
+                emit();
+                return;
+            }
+            for (int j = 0; j < pos; ++j) {
+                S[pos] = S[j];
+                self(self, pos + 1);
+                for (const auto& [x, _] : nbrs[S[j]]) {
+                    S[pos] = x;
+                    self(self, pos + 1);
+                }
+            }
+        };
 
-    for (int iter = 0; iter < maxIter; ++iter) {
-        std::unordered_map<std::vector<int>, int, VectorHash> updatedColor;
-        Encoder updateEnc;
+        for (int v = 0; v < n; ++v) {
+            S[0] = v;
+            extend(extend, 1);
+        }
 
-        for (const auto& S : tuples)
-            updatedColor[S] = updateEnc.encode(genLabelUpdate(S, color));
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        keys.shrink_to_fit();
+    }
 
-        std::cout << "iter " << iter + 1 << " : " << updateEnc.size() << " colors\n";
+    // 初期ラベル: 各ノードの次数と自己ループ、各ペアの一致と辺の向き
+    uint64_t labelInit(const Scratch& own) const {
+        const std::vector<int>& S = own.S;
+        uint64_t label = k;
+        for (int v : S) {
+            label = Utils::hashCombine(Utils::hashCombine(label, graph.outDegree(v)), graph.inDegree(v));
+            label = Utils::hashCombine(label, graph.hasEdge(v, v));
+        }
 
-        if (updatedColor == color)
-            break;
+        for (int i = 0; i < k; ++i) {
+            for (int j = i + 1; j < k; ++j) {
+                const int a = S[i], b = S[j];
+                label = Utils::hashCombine(label, (a == b ? 4 : 0) | (graph.hasEdge(a, b) ? 2 : 0) | (graph.hasEdge(b, a) ? 1 : 0));
+            }
+        }
 
-        color = std::move(updatedColor);
+        return label;
     }
 
-    std::vector<int> result;
-    result.reserve(color.size());
-    for (const auto& [_, cid] : color)
-        result.push_back(cid);
-    std::sort(result.begin(), result.end());
+    // 更新ラベル: 自身の色と、位置 i ごとに S[i] の隣接ノード x で置き換えた
+    // タプルの (辺の向き, 色) の組 (ソート済み)。連結でなくなるタプルは色 0、
+    // それ以外は色 + 1 で区別する
+    uint64_t labelUpdate(std::size_t index, Scratch& own) const {
+        auto& [S, sigs] = own;
+        uint64_t label = Utils::hashCombine(k, color[index]);
+
+        for (int i = 0; i < k; ++i) {
+            sigs.clear();
+            for (const auto& [x, dir] : nbrs[S[i]]) {
+                const uint64_t key = keys[index] - S[i] * place[i] + x * place[i];
+                const auto it = std::lower_bound(keys.begin(), keys.end(), key);
+                const uint64_t c = (it != keys.end() && *it == key) ? color[it - keys.begin()] + 1ULL : 0;
+                sigs.push_back(Utils::hashCombine(dir, c));
+            }
+            std::sort(sigs.begin(), sigs.end());
 
-    return result;
+            label = Utils::hashCombine(label, sigs.size());
+            for (uint64_t sig : sigs)
+                label = Utils::hashCombine(label, sig);
+        }
+
+        return label;
+    }
+};
+
+static int kWLPoolSize(std::size_t tuples, int threads) {
+    return threads > 0 ? static_cast<int>(std::min<std::size_t>(threads, std::max<std::size_t>(tuples, 1))) : threads;
 }
 
-struct StateQueue {
-    using State = std::pair<int, int>;
+std::vector<int> Feature::genkWL(const AdjList& adj, int k, int maxIter, int threads) {
+    Profiler::Scope scope("Feature::genkWL");
+    if (adj.getNodes().empty() || k <= 0)
+        return {};
 
-    std::queue<State> queue;
-    std::set<State> seen;
-    std::vector<bool> visited;
+    TupleColoring state(adj, k);
 
-    StateQueue(int maxNode) : visited(maxNode + 1, false) {}
+    ThreadPool pool(kWLPoolSize(state.size(), threads));
 
-    bool push(int node, int dist) {
-        State s = {node, dist}, rs = {node, -dist};
-        bool canPush = !visited[node] || seen.count(rs);
+    // 新しいラベルは旧色を含むので分割は細分化しかしない: 色数が増えなければ安定
+    int colors = 0;
+    for (int iter = 0; iter <= maxIter; ++iter) {
+        Encoder enc;
+        state.label(pool, iter == 0);
+        state.merge(enc);
+        state.remap(pool);
 
-        if (canPush) {
-            visited[node] = true;
-            seen.insert(s);
-            queue.push(s);
-        }
-        
-        return canPush;
-    }
+        if (enc.size() == colors)
+            break;
 
-    bool empty() const {
-        return queue.empty();
+        state.advance();
+        colors = enc.size();
     }
 
-    State pop() {
-        State front = queue.front();
-        queue.pop();
-        return front;
+    std::vector<int> result(state.colors().begin(), state.colors().end());
+    std::sort(result.begin(), result.end());
+
+    return result;
+}
+
+// TupleColoring / LocalTupleColoring の2グラフ同時精密化。
+// 両グラフのラベルを同じ Encoder で番号付けするので色が比較でき、
+// ヒストグラムが食い違った時点で非同型が確定する
+template <typename State>
+static bool jointRefine(State& stateA, State& stateB, ThreadPool& pool, int maxIter) {
+    int colors = 0;
+    for (int iter = 0; iter <= maxIter; ++iter) {
+        Encoder enc;
+        stateA.label(pool, iter == 0);
+        stateB.label(pool, iter == 0);
+        stateA.merge(enc);
+        stateB.merge(enc);
+        stateA.remap(pool);
+        stateB.remap(pool);
+
+        if (stateA.histogram(enc.size()) != stateB.histogram(enc.size()))
+            return false;
+        if (enc.size() == colors)
+            break;
+
+        stateA.advance();
+        stateB.advance();
+        colors = enc.size();
     }
-};
 
-std::unordered_map<int, DSet> Feature::genFeatState(int n, const NodeSet& nodes, const AdjList& adj, const AdjList& rev){
-    std::unordered_map<int, DSet> nodeToDset;
-    StateQueue stateQueue(Utils::max(nodes));
+    return true;
+}
 
-    nodeToDset[n].insert(0);
-    stateQueue.push(n, 0);
+bool Feature::kWLEquivalent(const AdjList& adjA, const AdjList& adjB, int k, int maxIter, int threads) {
+    Profiler::Scope scope("Feature::kWLEquivalent");
+    if (adjA.getNodes().size() != adjB.getNodes().size())
+        return false;
+    if (adjA.getNodes().empty() || k <= 0)
+        return true;
 
-    auto propagate = [&](const AdjList& adjlist, int src, int dist) {
-        for (int dst : adjlist[src]) {
-            nodeToDset[dst].insert(dist);
-            stateQueue.push(dst, dist);
-        }
-    };
+    TupleColoring stateA(adjA, k), stateB(adjB, k);
+    ThreadPool pool(kWLPoolSize(stateA.size(), threads));
+    return jointRefine(stateA, stateB, pool, maxIter);
+}
 
-    while (!stateQueue.empty()) {
-        auto [src, dist] = stateQueue.pop();
+bool Feature::localkWLEquivalent(const CSRGraph& graphA, const CSRGraph& graphB, int k, int maxIter, int threads) {
+    Profiler::Scope scope("Feature::localkWL");
+    if (graphA.size() != graphB.size())
+        return false;
+    if (graphA.empty() || k <= 0)
+        return true;
 
-        if (dist >= 0)
-            propagate(adj, src, dist + 1);
-        if (dist <= 0)
-            propagate(rev, src, dist - 1);
-    }
+    LocalTupleColoring stateA(graphA, k), stateB(graphB, k);
+    if (stateA.tupleCount() != stateB.tupleCount())
+        return false;
 
-    return nodeToDset;
+    ThreadPool pool(kWLPoolSize(stateA.size(), threads));
+    return jointRefine(stateA, stateB, pool, maxIter);
 }
 
 } // namespace Graph
\ No newline at end of file
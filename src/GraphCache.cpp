@@ -0,0 +1,74 @@
+#include "GraphCache.hpp"
+
+namespace Graph {
+
+GraphCache::GraphCache(std::size_t maxBytes, int threads)
+    : maxBytes(maxBytes), threads(threads) {}
+
+GraphCache::Ptr GraphCache::get(const std::string& filepath) {
+    auto it = index.find(filepath);
+    if (it != index.end()) {
+        ++hitCount;
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->second;
+    }
+
+    ++missCount;
+    auto graph = std::make_shared<const PreparedGraph>(PreparedGraph::loadCSV(filepath, threads));
+    put(filepath, graph);
+    return graph;
+}
+
+void GraphCache::put(const std::string& filepath, Ptr graph) {
+    auto it = index.find(filepath);
+    if (it != index.end()) {
+        usedBytes -= it->second->second->bytes();
+        entries.erase(it->second);
+        index.erase(it);
+    }
+
+    usedBytes += graph->bytes();
+    entries.emplace_front(filepath, std::move(graph));
+    index[filepath] = entries.begin();
+    evict();
+}
+
+bool GraphCache::contains(const std::string& filepath) const {
+    return index.count(filepath) > 0;
+}
+
+void GraphCache::clear() {
+    entries.clear();
+    index.clear();
+    usedBytes = 0;
+}
+
+void GraphCache::evict() {
+    if (maxBytes == 0) return;
+
+    while (usedBytes > maxBytes && entries.size() > 1) {
+        const Entry& last = entries.back();
+        usedBytes -= last.second->bytes();
+        index.erase(last.first);
+        entries.pop_back();
+    }
+}
+
+// --- Information access ---
+std::size_t GraphCache::size() const {
+    return entries.size();
+}
+
+std::size_t GraphCache::bytes() const {
+    return usedBytes;
+}
+
+std::size_t GraphCache::hits() const {
+    return hitCount;
+}
+
+std::size_t GraphCache::misses() const {
+    return missCount;
+}
+
+} // namespace Graph
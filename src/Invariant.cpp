@@ -0,0 +1,81 @@
+#include "Invariant.hpp"
+#include <vector>
+#include <algorithm>
+
+namespace Graph {
+
+uint64_t Invariant::hash(const CSRGraph& graph, int threads) {
+    return hash(graph, Feature::genPrint(graph, threads));
+}
+
+uint64_t Invariant::hash(const CSRGraph& graph, const std::map<FeatPrint, NodeSet>& feat) {
+    uint64_t seed = hashDegrees(graph);
+    seed = Utils::hashCombine(seed, hashFeatures(feat));
+    seed = Utils::hashCombine(seed, hashWL(graph));
+    return seed;
+}
+
+uint64_t Invariant::hashDegrees(const CSRGraph& graph) {
+    const int n = static_cast<int>(graph.size());
+
+    std::vector<Degs> degs;
+    degs.reserve(n);
+    for (int node = 0; node < n; ++node)
+        degs.emplace_back(graph.outDegree(node), graph.inDegree(node));
+    std::sort(degs.begin(), degs.end());
+
+    uint64_t seed = Utils::hashCombine(graph.size(), graph.edgeCount());
+    for (const auto& [out, in] : degs)
+        seed = Utils::hashCombine(Utils::hashCombine(seed, out), in);
+    return seed;
+}
+
+uint64_t Invariant::hashFeatures(const std::map<FeatPrint, NodeSet>& feat) {
+    uint64_t seed = feat.size();
+    for (const auto& [print, nodes] : feat)
+        seed = Utils::hashCombine(Utils::hashCombine(seed, print.hash), nodes.size());
+    return seed;
+}
+
+uint64_t Invariant::hashWL(const CSRGraph& graph, int maxIter) {
+    const int n = static_cast<int>(graph.size());
+
+    std::vector<uint64_t> color(n), next(n), sorted;
+    for (int node = 0; node < n; ++node)
+        color[node] = Utils::hashCombine(graph.outDegree(node), graph.inDegree(node));
+
+    auto countColors = [&](const std::vector<uint64_t>& c) {
+        sorted = c;
+        std::sort(sorted.begin(), sorted.end());
+        return std::unique(sorted.begin(), sorted.end()) - sorted.begin();
+    };
+
+    // Neighbor multisets are folded with a commutative sum of mixed colors
+    auto multisetHash = [&](NodeRange nodes) {
+        uint64_t sum = 0;
+        for (int node : nodes)
+            sum += Utils::mix(color[node]);
+        return sum;
+    };
+
+    auto colors = countColors(color);
+    for (int iter = 0; iter < maxIter; ++iter) {
+        for (int node = 0; node < n; ++node) {
+            uint64_t seed = Utils::hashCombine(color[node], multisetHash(graph.out(node)));
+            next[node] = Utils::hashCombine(seed, multisetHash(graph.in(node)));
+        }
+        color.swap(next);
+
+        const auto updated = countColors(color);
+        if (updated == colors) break;
+        colors = updated;
+    }
+
+    std::sort(color.begin(), color.end());
+    uint64_t seed = color.size();
+    for (uint64_t c : color)
+        seed = Utils::hashCombine(seed, c);
+    return seed;
+}
+
+} // namespace Graph
@@ -1,35 +1,305 @@
 #include "Isomorphism.hpp"
+#include "Canonical.hpp"
+#include "ThreadPool.hpp"
+#include "Timer.hpp"
+#include "VF2.hpp"
 #include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <queue>
+#include <tuple>
 
 namespace Graph {
 
-bool Isomorphism::solver(const AdjList& adjA, const AdjList& adjB) {
+// Per graphB node: search nodes tried before collecting automorphisms, and
+// canonical search tree nodes the collection may visit
+static constexpr std::size_t ProbeNodes = 4;
+static constexpr std::size_t AutomorphismNodes = 8;
+
+// Round limit of the localWL pre-check
+static constexpr int LocalWLRounds = 20;
+
+// Heap bytes reserved by a vector, for SolverStats::searchBytes
+template <typename T>
+static std::size_t vectorBytes(const std::vector<T>& values) {
+    return values.capacity() * sizeof(T);
+}
+
+// Tracks which recorded automorphisms of the candidate graph fix every
+// candidate assigned so far; two candidates in the same orbit of those
+// automorphisms lead to equivalent subtrees.
+//
+// The fixing automorphisms only shrink as the prefix grows, so an equal
+// count means an equal set: the orbit partition is computed once per
+// distinct set and kept on a stack (at most one entry per automorphism)
+// until the prefix it was computed for is unassigned.
+class Isomorphism::OrbitPruner {
+public:
+    explicit OrbitPruner(const std::vector<std::vector<int>>& automorphisms)
+        : automorphisms(automorphisms), moved(automorphisms.size(), 0), fixed(automorphisms.size()) {}
+
+    void assign(int node) {
+        ++depth;
+        for (std::size_t g = 0; g < automorphisms.size(); ++g)
+            if (automorphisms[g][node] != node && moved[g]++ == 0) --fixed;
+    }
+
+    void unassign(int node) {
+        --depth;
+        for (std::size_t g = 0; g < automorphisms.size(); ++g)
+            if (automorphisms[g][node] != node && --moved[g] == 0) ++fixed;
+        while (!orbits.empty() && orbits.back().depth > depth)
+            orbits.pop_back();
+    }
+
+    bool equivalent(int node, NodeRange tried) {
+        if (tried.empty() || fixed == 0) return false;
+
+        if (orbits.empty() || orbits.back().fixed != fixed)
+            orbits.push_back({depth, fixed, partition()});
+        const auto& root = orbits.back().root;
+        return std::any_of(tried.begin(), tried.end(), [&](int t) { return root[t] == root[node]; });
+    }
+
+private:
+    struct Orbits {
+        int depth;
+        std::size_t fixed;
+        std::vector<int> root;  // orbit representative of every node
+    };
+
+    const std::vector<std::vector<int>>& automorphisms;
+    std::vector<int> moved;
+    std::size_t fixed;
+    int depth = 0;
+    std::vector<Orbits> orbits;
+
+    std::vector<int> partition() const {
+        const int n = static_cast<int>(automorphisms.front().size());
+        std::vector<int> parent(n);
+        std::iota(parent.begin(), parent.end(), 0);
+
+        auto find = [&](int x) {
+            while (parent[x] != x) x = parent[x] = parent[parent[x]];
+            return x;
+        };
+        for (std::size_t g = 0; g < automorphisms.size(); ++g) {
+            if (moved[g]) continue;
+            for (int x = 0; x < n; ++x)
+                parent[find(x)] = find(automorphisms[g][x]);
+        }
+        for (int x = 0; x < n; ++x)
+            parent[x] = find(x);
+        return parent;
+    }
+};
+
+bool Isomorphism::solver(const AdjList& adjA, const AdjList& adjB, const SolverOptions& options) {
+    return solver(CSRGraph(adjA), CSRGraph(adjB), options);
+}
+
+bool Isomorphism::solver(const AdjList& adjA, const AdjList& adjB, IdMap& maps, const SolverOptions& options) {
+    const CSRGraph graphA(adjA), graphB(adjB);
     NodeMap nodeMap;
-    return solver(adjA, adjB, nodeMap);
+
+    maps.clear();
+    if (!solver(graphA, graphB, nodeMap, options))
+        return false;
+
+    maps.reserve(nodeMap.size());
+    for (int n = 0; n < (int)nodeMap.size(); ++n)
+        maps[graphA.id(n)] = graphB.id(nodeMap[n]);
+    return true;
 }
 
-bool Isomorphism::solver(const AdjList& adjA, const AdjList& adjB, NodeMap& maps) {
-    const auto featA = Feature::gen(adjA), featB = Feature::gen(adjB);
+bool Isomorphism::solver(const CSRGraph& graphA, const CSRGraph& graphB, const SolverOptions& options) {
+    NodeMap nodeMap;
+    return solver(graphA, graphB, nodeMap, options);
+}
+
+bool Isomorphism::solver(const CSRGraph& graphA, const CSRGraph& graphB, NodeMap& maps, const SolverOptions& options) {
+    return match(graphA, graphB, maps, options) == Result::Isomorphic;
+}
+
+bool Isomorphism::solver(const PreparedGraph& graphA, const PreparedGraph& graphB, const SolverOptions& options) {
+    NodeMap nodeMap;
+    return solver(graphA, graphB, nodeMap, options);
+}
+
+bool Isomorphism::solver(const PreparedGraph& graphA, const PreparedGraph& graphB, NodeMap& maps, const SolverOptions& options) {
+    return match(graphA, graphB, maps, options) == Result::Isomorphic;
+}
+
+Result Isomorphism::match(const CSRGraph& graphA, const CSRGraph& graphB, NodeMap& maps, const SolverOptions& options) {
+    SearchBudget budget(options.nodeLimit, options.timeLimit, options.cancel);
+    SolverStats* stats = options.stats;
+    GRAPH_STAT(if (stats) *stats = {});
+
+    maps.assign(graphA.size(), -1);
+    if (graphA.size() != graphB.size() || graphA.edgeCount() != graphB.edgeCount())
+        return Result::NotIsomorphic;
+
+    std::map<FeatPrint, NodeSet> featA, featB;
+    {
+        StatTimer timer(stats ? &stats->featureNanos : nullptr);
+        featA = Feature::genPrint(graphA, options.threads);
+        featB = Feature::genPrint(graphB, options.threads);
+    }
+
+    const Result result = solve(graphA, featA, graphB, featB, maps, options, budget, stats);
+    GRAPH_STAT(if (stats) stats->nodes = budget.spent());
+    return result;
+}
+
+Result Isomorphism::match(const PreparedGraph& graphA, const PreparedGraph& graphB, NodeMap& maps, const SolverOptions& options) {
+    SearchBudget budget(options.nodeLimit, options.timeLimit, options.cancel);
+    SolverStats* stats = options.stats;
+    GRAPH_STAT(if (stats) *stats = {});
+
+    maps.assign(graphA.getGraph().size(), -1);
+    if (graphA.getGraph().edgeCount() != graphB.getGraph().edgeCount() ||
+        graphA.getDegrees() != graphB.getDegrees())
+        return Result::NotIsomorphic;
+
+    const Result result = solve(
+        graphA.getGraph(), graphA.getFeatures(), graphB.getGraph(), graphB.getFeatures(),
+        maps, options, budget, stats
+    );
+    GRAPH_STAT(if (stats) stats->nodes = budget.spent());
+    return result;
+}
+
+Result Isomorphism::solve(
+    const CSRGraph& graphA, const std::map<FeatPrint, NodeSet>& featA,
+    const CSRGraph& graphB, const std::map<FeatPrint, NodeSet>& featB,
+    NodeMap& maps,
+    const SolverOptions& options,
+    SearchBudget& budget,
+    SolverStats* stats
+) {
+    maps.assign(graphA.size(), -1);
+    if (graphA.empty())
+        return graphB.empty() ? Result::Isomorphic : Result::NotIsomorphic;
+
+    // A found mapping is always valid; a failed search only proves
+    // non-isomorphism if it ran to completion
+    auto result = [&](bool matched) {
+        if (matched) return Result::Isomorphic;
+        return budget.exhausted() ? Result::Unknown : Result::NotIsomorphic;
+    };
+    auto phase = [&](std::uint64_t SolverStats::*nanos) {
+        return stats ? &(stats->*nanos) : nullptr;
+    };
+
+    // Stronger invariant than the feature partition, checked before any
+    // search but after the cheap checks, since the budget cannot interrupt it
+    auto localWLDiffers = [&] {
+        return options.localWL > 0 &&
+               !Feature::localkWLEquivalent(graphA, graphB, options.localWL, LocalWLRounds, options.threads);
+    };
+
+    if (options.engine != Engine::Groups) {
+        Colors colorsA(graphA.size()), colorsB(graphB.size());
+        {
+            StatTimer timer(phase(&SolverStats::setupNanos));
+            if (!featureColors(featA, featB, colorsA, colorsB))
+                return Result::NotIsomorphic;
+            if (options.engine == Engine::Refine && !Refinement::refine(graphA, colorsA, graphB, colorsB))
+                return Result::NotIsomorphic;
+            if (localWLDiffers())
+                return Result::NotIsomorphic;
+        }
+
+        StatTimer timer(phase(&SolverStats::searchNanos));
+        if (options.engine == Engine::VF2)
+            return result(VF2::match(graphA, graphB, colorsA, colorsB, maps, &budget));
+        return result(matchRefine(graphA, graphB, colorsA, colorsB, maps, budget));
+    }
 
     GroupList groups;
-    std::vector<NodeSet> nodeToGroup;
+    GroupIndex index;
+    PositionList positions;
+    std::vector<std::vector<int>> automorphisms;
+    {
+        StatTimer timer(phase(&SolverStats::setupNanos));
+        if (!setGroups(featA, featB, groups))
+            return Result::NotIsomorphic;
 
-    if (!setGroups(featA, featB, groups, nodeToGroup))
-        return false;
+        index.build(graphA, graphB, groups);
+        if (localWLDiffers())
+            return Result::NotIsomorphic;
+        positions = orderPositions(graphA, groups);
+    }
+
+    GRAPH_STAT(if (stats) {
+        stats->groups = groups.size();
+        stats->searchBytes += vectorBytes(groups) + vectorBytes(positions) +
+            vectorBytes(index.groupA) + vectorBytes(index.outOffsets) + vectorBytes(index.inOffsets) +
+            vectorBytes(index.outGroups) + vectorBytes(index.inGroups);
+        for (const auto& [groupA, groupB] : groups) {
+            stats->largestGroup = std::max(stats->largestGroup, groupA.size());
+            stats->searchBytes += vectorBytes(groupA) + vectorBytes(groupB);
+        }
+    });
+
+    auto search = [&](SearchBudget& searchBudget) {
+        StatTimer timer(phase(&SolverStats::searchNanos));
+        maps.assign(graphA.size(), -1);
+        if (options.threads != 1)
+            return matchParallel(graphA, graphB, groups, positions, index, maps, searchBudget, options.threads, automorphisms, stats);
+
+        OrbitPruner pruner(automorphisms);
+        return matchGroups(graphA, graphB, groups, positions, index, maps, searchBudget, 0, 0, automorphisms.empty() ? nullptr : &pruner, stats);
+    };
 
-    const AdjList revA = adjA.getReversed(), revB = adjB.getReversed();
+    if (options.automorphisms) {
+        // Most pairs, symmetric or not, are settled within a few nodes per
+        // node; only a search that outgrows that pays for automorphisms
+        SearchBudget probe(ProbeNodes * graphB.size(), budget);
+        const bool matched = search(probe);
+        if (matched || !probe.exhausted())
+            return result(matched);
+        if (budget.exhausted())
+            return Result::Unknown;
 
-    maps.assign(Utils::max(adjA.getNodes()) + 1, -1);
+        // Orbit pruning works on the candidate side, so the generators are
+        // automorphisms of graphB. Any subset of them prunes soundly, so the
+        // collection stops after a few tree nodes per graphB node.
+        StatTimer timer(phase(&SolverStats::setupNanos));
+        automorphisms = Canonical::automorphisms(graphB, featB, &budget, AutomorphismNodes * graphB.size());
+        if (budget.exhausted())
+            return Result::Unknown;
+    }
 
-    return matchGroups(adjA, revA, adjB, revB, groups, nodeToGroup, maps);
+    return result(search(budget));
+}
+
+bool Isomorphism::featureColors(
+    const std::map<FeatPrint, NodeSet>& featA,
+    const std::map<FeatPrint, NodeSet>& featB,
+    Colors& colorsA, Colors& colorsB
+) {
+    if (featA.size() != featB.size())
+        return false;
+
+    int color = 0;
+    for (auto itA = featA.begin(), itB = featB.begin(); itA != featA.end(); ++itA, ++itB, ++color) {
+        if (itA->first != itB->first || itA->second.size() != itB->second.size())
+            return false;
+        for (int n : itA->second) colorsA[n] = color;
+        for (int n : itB->second) colorsB[n] = color;
+    }
+    return true;
 }
 
 bool Isomorphism::setGroups(
-    const std::map<FeatSig, NodeSet>& featA,
-    const std::map<FeatSig, NodeSet>& featB,
-    GroupList& groups,
-    std::vector<NodeSet>& nodeToGroup
+    const std::map<FeatPrint, NodeSet>& featA,
+    const std::map<FeatPrint, NodeSet>& featB,
+    GroupList& groups
 ) {
+    Profiler::Scope scope("setGroups");
     if (featA.size() != featB.size())
         return false;
 
@@ -45,13 +315,6 @@ bool Isomorphism::setGroups(
             return false;
 
         groups.emplace_back(Utils::sort(nodesA), Utils::sort(nodesB));
-
-        int maxIdx = Utils::max(nodesA);
-        if ((int)nodeToGroup.size() <= maxIdx)
-            nodeToGroup.resize(maxIdx + 1);
-
-        for (int n : nodesA)
-            nodeToGroup[n] = nodesB;
     }
 
     groups = Utils::sort(
@@ -64,71 +327,446 @@ bool Isomorphism::setGroups(
     return true;
 }
 
+// Most-constrained-first: forced nodes (singleton groups) go first, then the
+// node with the most already ordered neighbors, breaking ties by smaller
+// group and then higher degree. Each groupA is rewritten in that order so
+// a group's positions still fill groupB's swap prefix front to back.
+PositionList Isomorphism::orderPositions(const CSRGraph& graphA, GroupList& groups) {
+    const int n = static_cast<int>(graphA.size());
+
+    std::vector<int> groupOf(n, -1);
+    for (int g = 0; g < (int)groups.size(); ++g)
+        for (int node : groups[g].first)
+            groupOf[node] = g;
+
+    auto domain = [&](int node) { return static_cast<int>(groups[groupOf[node]].first.size()); };
+    auto degree = [&](int node) { return graphA.outDegree(node) + graphA.inDegree(node); };
+
+    // (forced, connections, -domain, degree, -node); stale entries are skipped
+    using Key = std::tuple<bool, int, int, int, int>;
+    std::priority_queue<Key> heap;
+    std::vector<int> conn(n, 0);
+    std::vector<char> placed(n, 0);
+
+    for (int node = 0; node < n; ++node)
+        heap.emplace(domain(node) == 1, 0, -domain(node), degree(node), -node);
+
+    std::vector<int> sequence;
+    sequence.reserve(n);
+    while (!heap.empty()) {
+        const auto [forced, c, d, deg, negNode] = heap.top();
+        heap.pop();
+        const int node = -negNode;
+        if (placed[node] || c != conn[node]) continue;
+
+        placed[node] = 1;
+        sequence.push_back(node);
+
+        auto visit = [&](int w) {
+            if (placed[w]) return;
+            ++conn[w];
+            heap.emplace(domain(w) == 1, conn[w], -domain(w), degree(w), -w);
+        };
+        for (int w : graphA.out(node)) visit(w);
+        for (int w : graphA.in(node)) visit(w);
+    }
+
+    PositionList positions;
+    positions.reserve(n);
+    std::vector<int> filled(groups.size(), 0);
+    for (int node : sequence) {
+        const int g = groupOf[node];
+        groups[g].first[filled[g]] = node;
+        positions.emplace_back(g, filled[g]++);
+    }
+    return positions;
+}
+
 bool Isomorphism::matchGroups(
-    const AdjList& adjA, const AdjList& revA,
-    const AdjList& adjB, const AdjList& revB,
+    const CSRGraph& graphA, const CSRGraph& graphB,
     GroupList& groups,
-    const std::vector<NodeSet>& nodeToGroup,
+    const PositionList& positions,
+    const GroupIndex& index,
     NodeMap& maps,
-    int groupIdx,
-    int permIdx
+    SearchBudget& budget,
+    int start,
+    std::size_t verified,
+    OrbitPruner* pruner,
+    [[maybe_unused]] SolverStats* stats
 ) {
-    if (groupIdx == static_cast<int>(groups.size()))
-        return verifyMapping(adjA, adjB, maps);
+    Profiler::Scope scope("matchGroups");
 
-    auto& [groupA, groupB] = groups[groupIdx];
-    const int N = static_cast<int>(groupB.size());
+    // One frame per remaining search position. The frame arena is sized up
+    // front, so frame references stay valid, and the candidates tried at
+    // each frame share a single stack.
+    struct Frame {
+        int group, perm;
+        int next;              // next candidate index within groupB
+        std::size_t verified;  // graphA edges verified before this position
+        std::size_t tried;     // start of this frame's entries in triedStack
+        bool assigned;
+    };
 
-    if (permIdx == N)
-        return matchGroups(adjA, revA, adjB, revB, groups, nodeToGroup, maps, groupIdx + 1, 0);
+    const int total = static_cast<int>(positions.size());
+    std::vector<Frame> frames(total - start + 1);
+    std::vector<int> triedStack;
+    GRAPH_STAT(if (stats) stats->searchBytes += vectorBytes(frames));
 
-    for (int i = permIdx; i < N; ++i) {
-        std::swap(groupB[permIdx], groupB[i]);
+    auto enter = [&](int level, std::size_t edges) {
+        const int p = start + level;
+        const auto [group, perm] = p < total ? positions[p] : Position(-1, 0);
+        frames[level] = {group, perm, perm, edges, triedStack.size(), false};
+    };
+
+    auto undo = [&](Frame& f) {
+        auto& [groupA, groupB] = groups[f.group];
+        maps[groupA[f.perm]] = -1;
+        if (pruner)
+            pruner->unassign(groupB[f.perm]);
+        std::swap(groupB[f.perm], groupB[f.next - 1]);
+        f.assigned = false;
+    };
+
+    int level = 0;
+    enter(0, verified);
+
+    while (level >= 0) {
+        if (!budget.spend()) {
+            for (; level >= 0; --level)
+                if (frames[level].assigned) undo(frames[level]);
+            return false;
+        }
 
-        int oldNode = groupA[permIdx];
-        int newNode = groupB[permIdx];
-        maps[oldNode] = newNode;
+        Frame& f = frames[level];
 
-        if (verifySubMapping(adjA, revA, adjB, revB, maps, oldNode, nodeToGroup))
-            if (matchGroups(adjA, revA, adjB, revB, groups, nodeToGroup, maps, groupIdx, permIdx + 1))
+        // Every edge of graphA was checked against graphB when its second
+        // endpoint was mapped, so a full count with equal edge totals is a match
+        if (f.group == -1) {
+            if (f.verified == graphA.edgeCount() && f.verified == graphB.edgeCount())
                 return true;
+            --level;
+            continue;
+        }
+
+        if (f.assigned)
+            undo(f);
+
+        auto& [groupA, groupB] = groups[f.group];
+        const int N = static_cast<int>(groupB.size());
+        bool advanced = false;
+
+        while (f.next < N) {
+            const int i = f.next++;
+            std::swap(groupB[f.perm], groupB[i]);
+
+            int oldNode = groupA[f.perm];
+            int newNode = groupB[f.perm];
 
-        maps[oldNode] = -1;
-        std::swap(groupB[permIdx], groupB[i]);
+            if (pruner) {
+                const int* base = triedStack.data();
+                if (pruner->equivalent(newNode, {base + f.tried, base + triedStack.size()})) {
+                    GRAPH_STAT(if (stats) ++stats->pruned);
+                    std::swap(groupB[f.perm], groupB[i]);
+                    continue;
+                }
+                triedStack.push_back(newNode);
+                pruner->assign(newNode);
+            }
+            maps[oldNode] = newNode;
+
+            std::size_t closed = 0;
+            GRAPH_STAT(if (stats) ++stats->subMappingChecks);
+            if (verifySubMapping(graphA, graphB, maps, oldNode, index, closed)) {
+                f.assigned = true;
+                enter(level + 1, f.verified + closed);
+                ++level;
+                GRAPH_STAT(if (stats) stats->maxDepth = std::max(stats->maxDepth, start + level));
+                advanced = true;
+                break;
+            }
+
+            maps[oldNode] = -1;
+            if (pruner)
+                pruner->unassign(newNode);
+            std::swap(groupB[f.perm], groupB[i]);
+        }
+
+        if (!advanced) {
+            GRAPH_STAT(if (stats) ++stats->backtracks);
+            triedStack.resize(f.tried);
+            --level;
+        }
+    }
+
+    return false;
+}
+
+// --- GroupIndex ---
+void GroupIndex::build(const CSRGraph& graphA, const CSRGraph& graphB, const GroupList& groups) {
+    groupA.assign(graphA.size(), -1);
+    std::vector<int> groupB(graphB.size(), -1);
+    for (int g = 0; g < (int)groups.size(); ++g) {
+        for (int n : groups[g].first) groupA[n] = g;
+        for (int n : groups[g].second) groupB[n] = g;
+    }
+
+    auto collect = [&](bool forward, std::vector<std::size_t>& offsets, std::vector<int>& values) {
+        offsets.assign(graphB.size() + 1, 0);
+        values.clear();
+        for (int n = 0; n < (int)graphB.size(); ++n) {
+            const std::size_t begin = values.size();
+            for (int m : forward ? graphB.out(n) : graphB.in(n))
+                values.push_back(groupB[m]);
+            std::sort(values.begin() + begin, values.end());
+            values.erase(std::unique(values.begin() + begin, values.end()), values.end());
+            offsets[n + 1] = values.size();
+        }
+        values.shrink_to_fit();
+    };
+
+    collect(true, outOffsets, outGroups);
+    collect(false, inOffsets, inGroups);
+}
+
+bool GroupIndex::reaches(int nodeB, int group, bool forward) const {
+    const auto& offsets = forward ? outOffsets : inOffsets;
+    const int* base = (forward ? outGroups : inGroups).data();
+    return std::binary_search(base + offsets[nodeB], base + offsets[nodeB + 1], group);
+}
+
+// Search prefix queue: the owner pops from the back, thieves from the front
+class TaskDeque {
+public:
+    void push(std::vector<int> task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+
+    bool pop(std::vector<int>& task, bool owner) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tasks.empty()) return false;
+        if (owner) {
+            task = std::move(tasks.back());
+            tasks.pop_back();
+        } else {
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        return true;
+    }
+
+private:
+    std::mutex mutex;
+    std::deque<std::vector<int>> tasks;
+};
+
+bool Isomorphism::matchParallel(
+    const CSRGraph& graphA, const CSRGraph& graphB,
+    const GroupList& groups,
+    const PositionList& positions,
+    const GroupIndex& index,
+    NodeMap& maps,
+    SearchBudget& budget,
+    int threads,
+    const std::vector<std::vector<int>>& automorphisms,
+    SolverStats* stats
+) {
+    const int total = static_cast<int>(positions.size());
+
+    // A task is the list of B nodes chosen for the first positions; replay
+    // rebuilds the swapped groups, partial map and verified edge count that
+    // matchGroups expects
+    auto replay = [&](const std::vector<int>& prefix, GroupList& localGroups, NodeMap& localMaps) {
+        localGroups = groups;
+        localMaps.assign(graphA.size(), -1);
+        std::size_t verified = 0;
+        for (int p = 0; p < (int)prefix.size(); ++p) {
+            const auto [g, i] = positions[p];
+            auto& [groupA, groupB] = localGroups[g];
+            std::iter_swap(groupB.begin() + i, std::find(groupB.begin() + i, groupB.end(), prefix[p]));
+            localMaps[groupA[i]] = prefix[p];
+            verifySubMapping(graphA, graphB, localMaps, groupA[i], index, verified);
+        }
+        return verified;
+    };
+
+    ThreadPool pool(threads);
+    const std::size_t target = static_cast<std::size_t>(pool.size()) * 16;
+
+    // Expand the top levels breadth-first until there are enough tasks
+    std::vector<std::vector<int>> tasks{{}};
+    GroupList localGroups;
+    NodeMap localMaps;
+    int depth = 0;
+
+    while (depth < total && tasks.size() < target) {
+        const auto [g, i] = positions[depth];
+        std::vector<std::vector<int>> expanded;
+
+        for (const auto& prefix : tasks) {
+            replay(prefix, localGroups, localMaps);
+            const auto& [groupA, groupB] = localGroups[g];
+            for (int j = i; j < (int)groupB.size(); ++j) {
+                if (!budget.spend())
+                    return false;
+                localMaps[groupA[i]] = groupB[j];
+                std::size_t closed = 0;
+                GRAPH_STAT(if (stats) ++stats->subMappingChecks);
+                if (verifySubMapping(graphA, graphB, localMaps, groupA[i], index, closed)) {
+                    expanded.push_back(prefix);
+                    expanded.back().push_back(groupB[j]);
+                }
+            }
+        }
+
+        tasks = std::move(expanded);
+        ++depth;
+        if (tasks.empty())
+            return false;
+    }
+
+    std::vector<TaskDeque> deques(pool.size());
+    for (std::size_t t = 0; t < tasks.size(); ++t)
+        deques[t % deques.size()].push(std::move(tasks[t]));
+
+    // The first worker to find a mapping halts the shared budget, which
+    // stops the others
+    bool found = false;
+    std::mutex resultMutex;
+
+    pool.run(pool.size(), [&](int, int self) {
+        GroupList localGroups;
+        NodeMap localMaps;
+        std::vector<int> prefix;
+        SolverStats localStats;
+
+        auto take = [&] {
+            if (deques[self].pop(prefix, true)) return true;
+            for (int k = 1; k < (int)deques.size(); ++k)
+                if (deques[(self + k) % deques.size()].pop(prefix, false)) return true;
+            return false;
+        };
+
+        while (!budget.stopped() && take()) {
+            const std::size_t verified = replay(prefix, localGroups, localMaps);
+
+            // Only automorphisms fixing the replayed prefix may prune below it
+            std::unique_ptr<OrbitPruner> pruner;
+            if (!automorphisms.empty()) {
+                pruner = std::make_unique<OrbitPruner>(automorphisms);
+                for (int node : prefix) pruner->assign(node);
+            }
+
+            if (matchGroups(graphA, graphB, localGroups, positions, index, localMaps, budget, depth, verified,
+                            pruner.get(), stats ? &localStats : nullptr)) {
+                std::lock_guard<std::mutex> lock(resultMutex);
+                if (!found) {
+                    maps = localMaps;
+                    found = true;
+                    budget.halt();
+                }
+            }
+        }
+
+        GRAPH_STAT(if (stats) {
+            std::lock_guard<std::mutex> lock(resultMutex);
+            stats->merge(localStats);
+        });
+    });
+
+    return found;
+}
+
+bool Isomorphism::matchRefine(
+    const CSRGraph& graphA, const CSRGraph& graphB,
+    const Colors& colorsA, const Colors& colorsB,
+    NodeMap& maps,
+    SearchBudget& budget
+) {
+    if (!budget.spend())
+        return false;
+
+    // Target cell: the smallest non-singleton color class
+    const int colors = Refinement::count(colorsA);
+    std::vector<int> cellSize(colors, 0);
+    for (int c : colorsA) ++cellSize[c];
+
+    int target = -1;
+    for (int c = 0; c < colors; ++c)
+        if (cellSize[c] > 1 && (target == -1 || cellSize[c] < cellSize[target]))
+            target = c;
+
+    // Discrete partition: colors define the only candidate mapping
+    if (target == -1) {
+        std::vector<int> nodeB(colors);
+        for (int n = 0; n < (int)colorsB.size(); ++n)
+            nodeB[colorsB[n]] = n;
+        for (int n = 0; n < (int)colorsA.size(); ++n)
+            maps[n] = nodeB[colorsA[n]];
+        if (verifyMapping(graphA, graphB, maps))
+            return true;
+        std::fill(maps.begin(), maps.end(), -1);
+        return false;
+    }
+
+    // Individualize the first node of the cell in A against every node of
+    // the cell in B, then refine both graphs before descending
+    const int nodeA = static_cast<int>(std::find(colorsA.begin(), colorsA.end(), target) - colorsA.begin());
+
+    Colors nextA, nextB;
+    for (int nodeB = 0; nodeB < (int)colorsB.size(); ++nodeB) {
+        if (colorsB[nodeB] != target) continue;
+
+        nextA = colorsA;
+        nextB = colorsB;
+        nextA[nodeA] = nextB[nodeB] = colors;
+
+        if (Refinement::refine(graphA, nextA, graphB, nextB) &&
+            matchRefine(graphA, graphB, nextA, nextB, maps, budget))
+            return true;
     }
 
     return false;
 }
 
 bool Isomorphism::verifySubMapping(
-    const AdjList& adjA, const AdjList& revA,
-    const AdjList& adjB, const AdjList& revB,
+    const CSRGraph& graphA, const CSRGraph& graphB,
     const NodeMap& maps,
     int srcA,
-    const std::vector<NodeSet>& nodeToGroup
+    const GroupIndex& index,
+    std::size_t& closed
 ) {
     int srcB = maps[srcA];
 
-    auto check = [&](const AdjList& adjA, const AdjList& adjB) {
-        for (int dstA : adjA[srcA]) {
+    auto check = [&](NodeRange dstsA, bool forward) {
+        for (int dstA : dstsA) {
             int dstB = maps[dstA];
-            if ((dstB != -1 && !adjB.hasEdge(srcB, dstB)) ||
-                (dstB == -1 && !Utils::common(nodeToGroup[dstA], adjB[srcB])))
+            if (dstB == -1) {
+                if (!index.reaches(srcB, index.groupA[dstA], forward))
+                    return false;
+            } else if (!(forward ? graphB.hasEdge(srcB, dstB) : graphB.hasEdge(dstB, srcB))) {
                 return false;
+            } else if (forward || dstA != srcA) {
+                // A self-loop shows up in both lists; count it once
+                ++closed;
+            }
         }
         return true;
     };
 
-    return check(adjA, adjB) && check(revA, revB);
+    return check(graphA.out(srcA), true) && check(graphA.in(srcA), false);
 }
 
-bool Isomorphism::verifyMapping(const AdjList& adjA, const AdjList& adjB, const NodeMap& maps) {
-    AdjList transformed;
-    for (const auto& [src, dsts] : adjA)
-        for (int dst : dsts)
-            transformed.insert(maps[src], maps[dst]);
+bool Isomorphism::verifyMapping(const CSRGraph& graphA, const CSRGraph& graphB, const NodeMap& maps) {
+    if (graphA.edgeCount() != graphB.edgeCount())
+        return false;
 
-    return transformed == adjB;
+    for (int src = 0; src < (int)graphA.size(); ++src)
+        for (int dst : graphA.out(src))
+            if (!graphB.hasEdge(maps[src], maps[dst]))
+                return false;
+
+    return true;
 }
 
 } // namespace Graph
@@ -0,0 +1,46 @@
+#include "PreparedGraph.hpp"
+#include <algorithm>
+
+namespace Graph {
+
+PreparedGraph::PreparedGraph(CSRGraph graph, int threads) : graph(std::move(graph)) {
+    const CSRGraph& g = this->graph;
+    feat = Feature::genPrint(g, threads);
+
+    degs.reserve(g.size());
+    for (int node = 0; node < (int)g.size(); ++node)
+        degs.emplace_back(g.outDegree(node), g.inDegree(node));
+    std::sort(degs.begin(), degs.end());
+}
+
+PreparedGraph::PreparedGraph(const AdjList& adj, int threads)
+    : PreparedGraph(CSRGraph(adj), threads) {}
+
+PreparedGraph PreparedGraph::loadCSV(const std::string& filepath, int threads) {
+    return PreparedGraph(CSRGraph::loadCSV(filepath), threads);
+}
+
+// --- Information access ---
+const CSRGraph& PreparedGraph::getGraph() const {
+    return graph;
+}
+
+const std::map<FeatPrint, NodeSet>& PreparedGraph::getFeatures() const {
+    return feat;
+}
+
+const std::vector<Degs>& PreparedGraph::getDegrees() const {
+    return degs;
+}
+
+std::size_t PreparedGraph::bytes() const {
+    // Rough per-entry overhead of NodeSet and std::map nodes
+    constexpr std::size_t setNodeBytes = 32, mapNodeBytes = 64;
+
+    std::size_t total = sizeof(*this) + graph.bytes() + degs.capacity() * sizeof(Degs);
+    for (const auto& [print, nodes] : feat)
+        total += mapNodeBytes + print.sig.capacity() * sizeof(uint64_t) + nodes.size() * setNodeBytes;
+    return total;
+}
+
+} // namespace Graph
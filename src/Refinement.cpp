@@ -0,0 +1,94 @@
+#include "Refinement.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include "Utils.hpp"
+
+namespace Graph {
+
+using Signature = std::pair<int, uint64_t>;
+
+// (old color, hash of the out- and in-neighbor color multisets)
+static void signatures(const CSRGraph& graph, const Colors& colors, std::vector<Signature>& sigs) {
+    auto multisetHash = [&](NodeRange nodes) {
+        uint64_t sum = 0;
+        for (int node : nodes)
+            sum += Utils::mix(static_cast<uint64_t>(colors[node]));
+        return sum;
+    };
+
+    sigs.resize(graph.size());
+    for (int node = 0; node < (int)graph.size(); ++node) {
+        const uint64_t out = multisetHash(graph.out(node));
+        const uint64_t in = multisetHash(graph.in(node));
+        sigs[node] = {colors[node], Utils::hashCombine(out, in)};
+    }
+}
+
+// Numbers signatures by their rank among the distinct values of sorted
+static void relabel(const std::vector<Signature>& sigs, const std::vector<Signature>& sorted, Colors& colors) {
+    for (int node = 0; node < (int)sigs.size(); ++node)
+        colors[node] = static_cast<int>(std::lower_bound(sorted.begin(), sorted.end(), sigs[node]) - sorted.begin());
+}
+
+static void distinct(std::vector<Signature>& sorted) {
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+}
+
+bool Refinement::refine(const CSRGraph& graphA, Colors& colorsA, const CSRGraph& graphB, Colors& colorsB) {
+    if (colorsA.size() != colorsB.size())
+        return false;
+
+    std::vector<Signature> sigsA, sigsB, sorted;
+    std::vector<int> histA, histB;
+    int colors = -1;
+
+    while (true) {
+        signatures(graphA, colorsA, sigsA);
+        signatures(graphB, colorsB, sigsB);
+
+        sorted = sigsA;
+        sorted.insert(sorted.end(), sigsB.begin(), sigsB.end());
+        distinct(sorted);
+
+        relabel(sigsA, sorted, colorsA);
+        relabel(sigsB, sorted, colorsB);
+
+        const int updated = static_cast<int>(sorted.size());
+        histA.assign(updated, 0);
+        histB.assign(updated, 0);
+        for (int c : colorsA) ++histA[c];
+        for (int c : colorsB) ++histB[c];
+        if (histA != histB)
+            return false;
+
+        if (updated == colors)
+            return true;
+        colors = updated;
+    }
+}
+
+int Refinement::refine(const CSRGraph& graph, Colors& colors) {
+    std::vector<Signature> sigs, sorted;
+    int count = -1;
+
+    while (true) {
+        signatures(graph, colors, sigs);
+
+        sorted = sigs;
+        distinct(sorted);
+        relabel(sigs, sorted, colors);
+
+        const int updated = static_cast<int>(sorted.size());
+        if (updated == count)
+            return count;
+        count = updated;
+    }
+}
+
+int Refinement::count(const Colors& colors) {
+    return colors.empty() ? 0 : *std::max_element(colors.begin(), colors.end()) + 1;
+}
+
+} // namespace Graph
@@ -0,0 +1,55 @@
+#include "SearchBudget.hpp"
+
+namespace Graph {
+
+// Reading the clock costs far more than a search step, so the deadline is
+// polled every this many nodes
+static constexpr std::size_t PollInterval = 256;
+
+SearchBudget::SearchBudget(std::size_t nodeLimit, std::chrono::milliseconds timeLimit, const std::atomic<bool>* cancel)
+    : nodeLimit(nodeLimit), timed(timeLimit.count() > 0), deadline(Clock::now() + timeLimit), cancel(cancel) {}
+
+SearchBudget::SearchBudget(std::size_t nodeLimit, SearchBudget& parent)
+    : nodeLimit(nodeLimit), parent(&parent) {}
+
+bool SearchBudget::spend() {
+    if (halted.load(std::memory_order_relaxed))
+        return false;
+    if (parent && !parent->spend()) {
+        exhaust();
+        return false;
+    }
+
+    const std::size_t count = nodes.fetch_add(1, std::memory_order_relaxed) + 1;
+    if ((nodeLimit && count > nodeLimit) ||
+        (cancel && cancel->load(std::memory_order_relaxed)) ||
+        (timed && count % PollInterval == 0 && Clock::now() >= deadline)) {
+        exhaust();
+        return false;
+    }
+    return true;
+}
+
+void SearchBudget::halt() {
+    halted.store(true, std::memory_order_relaxed);
+}
+
+void SearchBudget::exhaust() {
+    ranOut.store(true, std::memory_order_relaxed);
+    halted.store(true, std::memory_order_relaxed);
+}
+
+// --- Information access ---
+bool SearchBudget::stopped() const {
+    return halted.load(std::memory_order_relaxed);
+}
+
+bool SearchBudget::exhausted() const {
+    return ranOut.load(std::memory_order_relaxed);
+}
+
+std::size_t SearchBudget::spent() const {
+    return nodes.load(std::memory_order_relaxed);
+}
+
+} // namespace Graph
@@ -0,0 +1,21 @@
+#include "SolverStats.hpp"
+#include <algorithm>
+
+namespace Graph {
+
+void SolverStats::merge(const SolverStats& other) {
+    featureNanos += other.featureNanos;
+    setupNanos += other.setupNanos;
+    searchNanos += other.searchNanos;
+
+    nodes += other.nodes;
+    subMappingChecks += other.subMappingChecks;
+    backtracks += other.backtracks;
+    pruned += other.pruned;
+    maxDepth = std::max(maxDepth, other.maxDepth);
+    groups = std::max(groups, other.groups);
+    largestGroup = std::max(largestGroup, other.largestGroup);
+    searchBytes += other.searchBytes;
+}
+
+} // namespace Graph
@@ -0,0 +1,81 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(int workers) {
+    if (workers <= 0)
+        workers = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int worker = 1; worker < workers; ++worker)
+        threads.emplace_back(&ThreadPool::loop, this, worker);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads)
+        thread.join();
+}
+
+void ThreadPool::run(int count, const Task& task) {
+    if (count <= 0) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = &task;
+        this->count = count;
+        next = 0;
+        error = nullptr;
+        busy = static_cast<int>(threads.size());
+        ++generation;
+    }
+    wake.notify_all();
+
+    work(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return busy == 0; });
+    this->task = nullptr;
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+int ThreadPool::size() const {
+    return static_cast<int>(threads.size()) + 1;
+}
+
+void ThreadPool::loop(int worker) {
+    int seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+
+        work(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --busy;
+        }
+        done.notify_one();
+    }
+}
+
+void ThreadPool::work(int worker) {
+    for (int index = next++; index < count; index = next++) {
+        try {
+            (*task)(worker, index);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) error = std::current_exception();
+            next = count;
+        }
+    }
+}
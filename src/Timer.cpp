@@ -4,6 +4,9 @@
 #include <ctime>
 #include <iomanip>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
 
 void Timer::start() {
@@ -20,23 +23,29 @@ void Timer::stop() {
     running = false;
 }
 
+std::uint64_t Timer::nanos() const {
+    const TimePoint end = running ? Clock::now() : endTime;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - startTime).count();
+}
+
 std::string Timer::get() const {
     if (running) {
         std::cerr << "[Timer] Warning: Timer is still running." << std::endl;
         return "";
     }
 
-    auto duration = std::chrono::duration_cast<std::chrono::seconds>(endTime - startTime);
-    int totalSec = static_cast<int>(duration.count());
+    const std::uint64_t totalMs = nanos() / 1000000;
 
-    int hours   = totalSec / 3600;
-    int minutes = (totalSec % 3600) / 60;
-    int seconds = totalSec % 60;
+    int hours   = static_cast<int>(totalMs / 3600000);
+    int minutes = static_cast<int>(totalMs % 3600000 / 60000);
+    int seconds = static_cast<int>(totalMs % 60000 / 1000);
+    int millis  = static_cast<int>(totalMs % 1000);
 
     std::ostringstream oss;
     oss << std::setw(2) << std::setfill('0') << hours << ":"
         << std::setw(2) << std::setfill('0') << minutes << ":"
-        << std::setw(2) << std::setfill('0') << seconds;
+        << std::setw(2) << std::setfill('0') << seconds << "."
+        << std::setw(3) << std::setfill('0') << millis;
 
     return oss.str();
 }
@@ -57,4 +66,183 @@ std::string Timer::now() {
     std::ostringstream oss;
     oss << std::put_time(&localTime, "%Y-%m-%d %H:%M:%S");
     return oss.str();
-}
\ No newline at end of file
+}
+
+// --- Profiler ---
+struct Profiler::Log {
+    int thread = 0;
+    std::vector<std::string> stack;  // paths of the open scopes, owner thread only
+
+    struct Totals {
+        std::uint64_t calls = 0;
+        std::uint64_t nanos = 0;
+    };
+    struct Event {
+        const char* name;
+        std::size_t path;  // index into pathNames
+        std::uint64_t begin, duration;
+    };
+
+    // Guards the recorded data against report() and reset() from other threads
+    std::mutex mutex;
+    std::map<std::string, Totals> phases;
+    std::vector<std::string> pathNames;
+    std::map<std::string, std::size_t> pathIds;
+    std::vector<Event> events;
+};
+
+// Logs outlive their threads, so phases run on pool workers are still
+// reported after the pool is gone
+struct Profiler::Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Log>> logs;
+};
+
+std::atomic<bool> Profiler::active{false};
+static std::atomic<Timer::Clock::rep> epoch{Timer::Clock::now().time_since_epoch().count()};
+
+Profiler::Registry& Profiler::registry() {
+    static Registry instance;
+    return instance;
+}
+
+Profiler::Log& Profiler::threadLog() {
+    thread_local Log* log = nullptr;
+    if (!log) {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.logs.push_back(std::make_unique<Log>());
+        log = reg.logs.back().get();
+        log->thread = static_cast<int>(reg.logs.size()) - 1;
+    }
+    return *log;
+}
+
+std::uint64_t Profiler::elapsed() {
+    const Timer::Clock::duration since(Timer::Clock::now().time_since_epoch().count() - epoch.load(std::memory_order_relaxed));
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(since).count();
+}
+
+Profiler::Scope::Scope(const char* name) {
+    if (!active.load(std::memory_order_relaxed))
+        return;
+
+    log = &threadLog();
+    this->name = name;
+    log->stack.push_back(log->stack.empty() ? std::string(name) : log->stack.back() + "/" + name);
+    begin = elapsed();
+    timer.start();
+}
+
+Profiler::Scope::~Scope() {
+    if (!log)
+        return;
+    timer.stop();
+
+    const std::string& path = log->stack.back();
+    std::lock_guard<std::mutex> lock(log->mutex);
+
+    auto& totals = log->phases[path];
+    ++totals.calls;
+    totals.nanos += timer.nanos();
+
+    const auto [it, added] = log->pathIds.try_emplace(path, log->pathNames.size());
+    if (added)
+        log->pathNames.push_back(path);
+    log->events.push_back({name, it->second, begin, timer.nanos()});
+
+    log->stack.pop_back();
+}
+
+void Profiler::enable(bool on) {
+    active.store(on, std::memory_order_relaxed);
+}
+
+bool Profiler::enabled() {
+    return active.load(std::memory_order_relaxed);
+}
+
+void Profiler::reset() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (auto& log : reg.logs) {
+        std::lock_guard<std::mutex> logLock(log->mutex);
+        log->phases.clear();
+        log->pathNames.clear();
+        log->pathIds.clear();
+        log->events.clear();
+    }
+    epoch.store(Timer::Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+}
+
+std::vector<Profiler::Phase> Profiler::report() {
+    std::map<std::string, Phase> merged;
+
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (auto& log : reg.logs) {
+        std::lock_guard<std::mutex> logLock(log->mutex);
+        for (const auto& [path, totals] : log->phases) {
+            Phase& phase = merged[path];
+            phase.path = path;
+            phase.calls += totals.calls;
+            phase.nanos += totals.nanos;
+            ++phase.threads;
+        }
+    }
+
+    std::vector<Phase> phases;
+    phases.reserve(merged.size());
+    for (auto& [path, phase] : merged)
+        phases.push_back(std::move(phase));
+    return phases;
+}
+
+static std::string quote(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') quoted += '\\';
+        quoted += c;
+    }
+    return quoted + '"';
+}
+
+void Profiler::writeJSON(std::ostream& out) {
+    out << "{\"phases\": [";
+    const char* separator = "\n";
+    for (const Phase& phase : report()) {
+        out << separator << "  {\"path\": " << quote(phase.path)
+            << ", \"calls\": " << phase.calls
+            << ", \"nanos\": " << phase.nanos
+            << ", \"threads\": " << phase.threads << "}";
+        separator = ",\n";
+    }
+    out << "\n]}\n";
+}
+
+void Profiler::writeTrace(std::ostream& out) {
+    const auto flags = out.flags();
+    const auto precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+
+    out << "{\"traceEvents\": [";
+    const char* separator = "\n";
+
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (auto& log : reg.logs) {
+        std::lock_guard<std::mutex> logLock(log->mutex);
+        for (const auto& event : log->events) {
+            out << separator << "  {\"name\": " << quote(event.name)
+                << ", \"cat\": \"phase\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << log->thread
+                << ", \"ts\": " << event.begin / 1000.0
+                << ", \"dur\": " << event.duration / 1000.0
+                << ", \"args\": {\"path\": " << quote(log->pathNames[event.path]) << "}}";
+            separator = ",\n";
+        }
+    }
+    out << "\n], \"displayTimeUnit\": \"ns\"}\n";
+
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,278 @@
+#include "VF2.hpp"
+#include <algorithm>
+#include <queue>
+#include <tuple>
+
+namespace Graph {
+
+// Matching state. Terminal sets hold the unmatched neighbors of matched
+// nodes; a node's entry is the depth stamp at which it joined (0 if it is
+// not in the set), so backtracking removes exactly what a step added.
+struct VF2::State {
+    const CSRGraph& graphA;
+    const CSRGraph& graphB;
+    const Colors& colorsA;
+    const Colors& colorsB;
+
+    std::vector<int> coreA, coreB;
+    std::vector<int> outA, inA, outB, inB;
+
+    // How a node's neighbors split between matched nodes and the terminal
+    // sets; equal for both sides of every feasible pair
+    struct Counts {
+        int matched = 0, termOut = 0, termIn = 0, fresh = 0;
+        bool loop = false;
+
+        bool operator==(const Counts& other) const {
+            return std::tie(matched, termOut, termIn, fresh, loop) ==
+                   std::tie(other.matched, other.termOut, other.termIn, other.fresh, other.loop);
+        }
+    };
+
+    State(const CSRGraph& graphA, const CSRGraph& graphB, const Colors& colorsA, const Colors& colorsB)
+        : graphA(graphA), graphB(graphB), colorsA(colorsA), colorsB(colorsB),
+          coreA(graphA.size(), -1), coreB(graphB.size(), -1),
+          outA(graphA.size(), 0), inA(graphA.size(), 0),
+          outB(graphB.size(), 0), inB(graphB.size(), 0) {}
+
+    static Counts count(NodeRange nbrs, int self, const std::vector<int>& core,
+                        const std::vector<int>& termOut, const std::vector<int>& termIn) {
+        Counts c;
+        for (int w : nbrs) {
+            if (w == self) {
+                c.loop = true;
+            } else if (core[w] != -1) {
+                ++c.matched;
+            } else {
+                if (termOut[w]) ++c.termOut;
+                if (termIn[w]) ++c.termIn;
+                if (!termOut[w] && !termIn[w]) ++c.fresh;
+            }
+        }
+        return c;
+    }
+
+    bool feasible(int u, int v) const {
+        if (colorsA[u] != colorsB[v] ||
+            graphA.outDegree(u) != graphB.outDegree(v) ||
+            graphA.inDegree(u) != graphB.inDegree(v))
+            return false;
+
+        if (!(count(graphA.out(u), u, coreA, outA, inA) == count(graphB.out(v), v, coreB, outB, inB)) ||
+            !(count(graphA.in(u), u, coreA, outA, inA) == count(graphB.in(v), v, coreB, outB, inB)))
+            return false;
+
+        // Equal matched counts plus every graphA edge present in graphB
+        // means the edges to matched nodes agree exactly
+        for (int w : graphA.out(u))
+            if (w != u && coreA[w] != -1 && !graphB.hasEdge(v, coreA[w]))
+                return false;
+        for (int w : graphA.in(u))
+            if (w != u && coreA[w] != -1 && !graphB.hasEdge(coreA[w], v))
+                return false;
+
+        return true;
+    }
+
+    void assign(int u, int v, int stamp) {
+        coreA[u] = v;
+        coreB[v] = u;
+        mark(graphA.out(u), outA, stamp);
+        mark(graphA.in(u), inA, stamp);
+        mark(graphB.out(v), outB, stamp);
+        mark(graphB.in(v), inB, stamp);
+    }
+
+    void unassign(int u, int stamp) {
+        const int v = coreA[u];
+        unmark(graphA.out(u), outA, stamp);
+        unmark(graphA.in(u), inA, stamp);
+        unmark(graphB.out(v), outB, stamp);
+        unmark(graphB.in(v), inB, stamp);
+        coreA[u] = -1;
+        coreB[v] = -1;
+    }
+
+    static void mark(NodeRange nbrs, std::vector<int>& term, int stamp) {
+        for (int w : nbrs)
+            if (!term[w]) term[w] = stamp;
+    }
+
+    static void unmark(NodeRange nbrs, std::vector<int>& term, int stamp) {
+        for (int w : nbrs)
+            if (term[w] == stamp) term[w] = 0;
+    }
+};
+
+// BFS from the rarest-colored, highest-degree unordered node. Within a BFS
+// level, nodes with the most already ordered neighbors go first, then higher
+// degree, then rarer color.
+std::vector<int> VF2::order(const CSRGraph& graph, const Colors& colors) {
+    const int n = static_cast<int>(graph.size());
+
+    std::vector<int> freq(Refinement::count(colors), 0);
+    for (int c : colors) ++freq[c];
+
+    auto degree = [&](int v) { return graph.outDegree(v) + graph.inDegree(v); };
+
+    std::vector<int> roots(n);
+    for (int v = 0; v < n; ++v) roots[v] = v;
+    std::sort(roots.begin(), roots.end(), [&](int a, int b) {
+        if (freq[colors[a]] != freq[colors[b]]) return freq[colors[a]] < freq[colors[b]];
+        if (degree(a) != degree(b)) return degree(a) > degree(b);
+        return a < b;
+    });
+
+    std::vector<int> result;
+    result.reserve(n);
+    std::vector<int> level(n, -1), conn(n, 0);
+    std::vector<char> placed(n, 0);
+
+    using Key = std::tuple<int, int, int, int>;  // conn, degree, -freq, -node
+    std::priority_queue<Key> heap;
+    std::vector<int> current, next;
+
+    for (int root : roots) {
+        if (level[root] != -1) continue;
+
+        int depth = 0;
+        level[root] = depth;
+        current.assign(1, root);
+
+        while (!current.empty()) {
+            for (int v : current)
+                heap.emplace(conn[v], degree(v), -freq[colors[v]], -v);
+
+            next.clear();
+            while (!heap.empty()) {
+                const int v = -std::get<3>(heap.top());
+                const int c = std::get<0>(heap.top());
+                heap.pop();
+                if (placed[v] || c != conn[v]) continue;  // stale entry
+
+                placed[v] = 1;
+                result.push_back(v);
+
+                auto visit = [&](int w) {
+                    if (placed[w]) return;
+                    ++conn[w];
+                    if (level[w] == -1) {
+                        level[w] = depth + 1;
+                        next.push_back(w);
+                    } else if (level[w] == depth) {
+                        heap.emplace(conn[w], degree(w), -freq[colors[w]], -w);
+                    }
+                };
+                for (int w : graph.out(v)) visit(w);
+                for (int w : graph.in(v)) visit(w);
+            }
+
+            current.swap(next);
+            ++depth;
+        }
+    }
+
+    return result;
+}
+
+bool VF2::match(
+    const CSRGraph& graphA, const CSRGraph& graphB,
+    const Colors& colorsA, const Colors& colorsB,
+    std::vector<int>& maps,
+    SearchBudget* budget
+) {
+    const int n = static_cast<int>(graphA.size());
+    maps.assign(n, -1);
+    if (graphB.size() != graphA.size())
+        return false;
+    if (n == 0)
+        return true;
+
+    const std::vector<int> sequence = order(graphA, colorsA);
+    std::vector<int> position(n);
+    for (int d = 0; d < n; ++d) position[sequence[d]] = d;
+
+    // Candidates for the node at each depth: the graphB neighbors of an
+    // earlier neighbor's partner (the one with the fewest such neighbors),
+    // or the whole color class when no earlier neighbor exists
+    std::vector<int> anchor(n, -1);
+    std::vector<char> anchorOut(n, 0);
+    for (int d = 0; d < n; ++d) {
+        const int u = sequence[d];
+        int best = 0;
+        for (int w : graphA.in(u)) {
+            if (position[w] < d && (anchor[d] == -1 || graphA.outDegree(w) < best)) {
+                anchor[d] = w;
+                anchorOut[d] = 1;
+                best = graphA.outDegree(w);
+            }
+        }
+        for (int w : graphA.out(u)) {
+            if (position[w] < d && (anchor[d] == -1 || graphA.inDegree(w) < best)) {
+                anchor[d] = w;
+                anchorOut[d] = 0;
+                best = graphA.inDegree(w);
+            }
+        }
+    }
+
+    // graphB nodes bucketed by color
+    const int colorCount = 1 + std::max(
+        *std::max_element(colorsA.begin(), colorsA.end()),
+        *std::max_element(colorsB.begin(), colorsB.end())
+    );
+    std::vector<std::size_t> bucketOffsets(colorCount + 1, 0);
+    for (int c : colorsB) ++bucketOffsets[c + 1];
+    for (int c = 0; c < colorCount; ++c) bucketOffsets[c + 1] += bucketOffsets[c];
+    std::vector<int> buckets(n);
+    std::vector<std::size_t> fill(bucketOffsets.begin(), bucketOffsets.end() - 1);
+    for (int v = 0; v < n; ++v) buckets[fill[colorsB[v]]++] = v;
+
+    State state(graphA, graphB, colorsA, colorsB);
+
+    // Explicit backtracking: next[d] is the next candidate index to try at depth d
+    std::vector<int> next(n + 1, 0);
+    int depth = 0;
+
+    while (depth >= 0) {
+        if (depth == n) {
+            maps = state.coreA;
+            return true;
+        }
+        if (budget && !budget->spend())
+            return false;
+
+        const int u = sequence[depth];
+        if (state.coreA[u] != -1)
+            state.unassign(u, depth + 1);
+
+        NodeRange candidates;
+        if (anchor[depth] == -1) {
+            const int* base = buckets.data();
+            candidates = {base + bucketOffsets[colorsA[u]], base + bucketOffsets[colorsA[u] + 1]};
+        } else {
+            const int partner = state.coreA[anchor[depth]];
+            candidates = anchorOut[depth] ? graphB.out(partner) : graphB.in(partner);
+        }
+
+        bool advanced = false;
+        while (next[depth] < (int)candidates.size()) {
+            const int v = candidates[next[depth]++];
+            if (state.coreB[v] == -1 && state.feasible(u, v)) {
+                state.assign(u, v, depth + 1);
+                next[++depth] = 0;
+                advanced = true;
+                break;
+            }
+        }
+
+        if (!advanced) {
+            next[depth] = 0;
+            --depth;
+        }
+    }
+
+    return false;
+}
+
+} // namespace Graph
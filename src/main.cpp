@@ -2,54 +2,121 @@
 #include <vector>
 #include <string>
 #include <filesystem>
-#include "AdjList.hpp"
+#include <unordered_map>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include "Canonical.hpp"
+#include "GraphCache.hpp"
+#include "Invariant.hpp"
 #include "Isomorphism.hpp"
 #include "Timer.hpp"
 
+// Bounds canonical labeling and each fallback comparison, so one
+// pathological graph cannot stall the whole run
+static const std::chrono::milliseconds SearchTimeLimit(10000);
+
+// Group representatives are reloaded from disk beyond this footprint
+static const std::size_t CacheBytes = std::size_t(1) << 30;
+
 std::vector<std::vector<std::string>> groupIsomorphicGraphs(const std::set<std::string>& filepaths) {
-    std::vector<std::vector<std::string>> groupSet;
+    // Graphs are only compared within an invariant bucket, and a
+    // representative is only labeled once another graph joins its bucket
+    struct Group {
+        std::vector<std::string> files;
+        bool labeled = false;     // canonical labeling attempted
+        std::string certificate;  // empty: not labeled or out of time
+    };
+    std::vector<Group> groups;
+    std::unordered_map<uint64_t, std::vector<size_t>> invariantToGroups;
+    Graph::GraphCache cache(CacheBytes);
     size_t current = 0;
     const size_t total = filepaths.size();
 
+    auto label = [](const Graph::PreparedGraph& graph) {
+        Graph::SearchBudget budget(0, SearchTimeLimit, nullptr);
+        const auto form = Graph::Canonical::label(graph, &budget);
+        return form.complete ? form.certificate : std::string();
+    };
+
+    // Bounded search against a group representative; only representatives
+    // are cached, everything else is dropped after its own iteration
+    auto compare = [&](const Graph::PreparedGraph& graph, size_t groupIdx) {
+        const std::string& representative = groups[groupIdx].files.front();
+        Graph::SolverOptions options;
+        options.timeLimit = SearchTimeLimit;
+        Graph::NodeMap maps;
+        const auto result = Graph::Isomorphism::match(graph, *cache.get(representative), maps, options);
+        if (result == Graph::Result::Unknown)
+            std::cout << " <-> " << Utils::getBasename(representative) << " : Unknown" << std::endl;
+        return result == Graph::Result::Isomorphic;
+    };
+
     for (const auto& filepath : filepaths) {
         ++current;
         std::cout << Timer::now() << std::endl
                   << "[" << current << "/" << total << "] " << Utils::getBasename(filepath) << std::endl;
 
-        Graph::AdjList targetGraph;
-        targetGraph.loadCSV(filepath);
-
-        bool foundGroup = false;
+        const auto graph = std::make_shared<const Graph::PreparedGraph>(Graph::PreparedGraph::loadCSV(filepath));
+        const uint64_t invariant = Graph::Invariant::hash(graph->getGraph(), graph->getFeatures());
+        std::cout << " invariant : " << std::hex << invariant << std::dec << std::endl;
 
-        for (auto& group : groupSet) {
-            const std::string& representativePath = group.front();
-            Graph::AdjList representativeGraph;
-            representativeGraph.loadCSV(representativePath);
+        auto& candidates = invariantToGroups[invariant];
+        bool labeled = false;
+        std::string certificate;
+        if (!candidates.empty()) {
+            labeled = true;
+            certificate = label(*graph);
+            std::cout << " certificate : " << (certificate.empty() ? "- (search limit reached)" : certificate) << std::endl;
+        }
 
-            std::cout << " <-> " << Utils::getBasename(representativePath) << " : " << std::flush;
+        std::optional<size_t> match;
+        for (size_t groupIdx : candidates) {
+            Group& group = groups[groupIdx];
+            if (!group.labeled) {
+                group.labeled = true;
+                group.certificate = label(*cache.get(group.files.front()));
+            }
 
-            if (Graph::Isomorphism::solver(representativeGraph, targetGraph)) {
-                std::cout << "Yes" << std::endl;
-                group.push_back(filepath);
-                foundGroup = true;
+            // Different certificates prove non-isomorphism; equal ones are
+            // confirmed by a search, which guards against hash collisions
+            if (!certificate.empty() && !group.certificate.empty() && certificate != group.certificate)
+                continue;
+            if (compare(*graph, groupIdx)) {
+                match = groupIdx;
                 break;
-            } else {
-                std::cout << "No" << std::endl;
             }
         }
 
-        if (!foundGroup)
-            groupSet.emplace_back(std::vector<std::string>{filepath});
-        
+        if (match) {
+            auto& files = groups[*match].files;
+            std::cout << " <-> " << Utils::getBasename(files.front()) << " : Yes" << std::endl;
+            files.push_back(filepath);
+        } else {
+            candidates.push_back(groups.size());
+            groups.push_back({{filepath}, labeled, std::move(certificate)});
+            cache.put(filepath, graph);
+        }
+
         std::cout << std::endl;
     }
 
+    std::vector<std::vector<std::string>> groupSet;
+    for (auto& group : groups)
+        groupSet.push_back(std::move(group.files));
     return groupSet;
 }
 
 int main() {
     const std::string dataDir = "data";
 
+    // GRAPH_PROFILE=<prefix> writes phase totals to <prefix>.json and a
+    // Chrome trace to <prefix>.trace.json
+    const char* profile = std::getenv("GRAPH_PROFILE");
+    Profiler::enable(profile != nullptr);
+
     for (const auto& [label, files] : Utils::getFilesSet(dataDir)) {
         if (files.empty()) continue;
 
@@ -58,5 +125,12 @@ int main() {
         std::cout << label << " : " << groups.size() << std::endl << std::endl;
     }
 
+    if (profile) {
+        std::ofstream json(std::string(profile) + ".json");
+        Profiler::writeJSON(json);
+        std::ofstream trace(std::string(profile) + ".trace.json");
+        Profiler::writeTrace(trace);
+    }
+
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,125 @@
+#include "catch.hpp"
+#include "Canonical.hpp"
+
+// Circulant digraph v -> v + step (mod n) for every step, relabeled
+// v -> v * scale (mod n) + offset
+static Graph::CSRGraph circulant(int n, std::initializer_list<int> steps, int scale, int offset) {
+    std::vector<Graph::Edge> edges;
+    for (int v = 0; v < n; ++v)
+        for (int step : steps)
+            edges.emplace_back((v * scale) % n + offset, ((v + step) % n * scale) % n + offset);
+    return Graph::CSRGraph(edges);
+}
+
+// Directed cycles of the given lengths; nodes are numbered with a stride so
+// isomorphic inputs do not share a labeling
+static Graph::CSRGraph cycles(const std::vector<int>& lengths, int stride) {
+    int total = 0;
+    for (int length : lengths) total += length;
+
+    std::vector<Graph::Edge> edges;
+    int base = 0;
+    for (int length : lengths) {
+        for (int i = 0; i < length; ++i)
+            edges.emplace_back((base + i) * stride % total, (base + (i + 1) % length) * stride % total);
+        base += length;
+    }
+    return Graph::CSRGraph(edges);
+}
+
+// Every automorphism maps every edge of graph onto an edge
+static bool preservesEdges(const Graph::CSRGraph& graph, const std::vector<std::vector<int>>& automorphisms) {
+    for (const auto& automorphism : automorphisms)
+        for (int v = 0; v < static_cast<int>(graph.size()); ++v)
+            for (int w : graph.out(v))
+                if (!graph.hasEdge(automorphism[v], automorphism[w])) return false;
+    return true;
+}
+
+TEST_CASE("Canonical: certificates identify isomorphism classes", "[canonical]") {
+    const auto formA = Graph::Canonical::label(circulant(20, {1, 3}, 1, 0));
+    const auto formB = Graph::Canonical::label(circulant(20, {1, 3}, 3, 1000));
+    const auto formC = Graph::Canonical::label(circulant(20, {1, 9}, 1, 0));
+
+    REQUIRE(formA.certificate == formB.certificate);
+    REQUIRE(formA.edges == formB.edges);
+    REQUIRE(formA.certificate != formC.certificate);
+
+    SECTION("Labeling reproduces the canonical edges") {
+        const auto graph = circulant(20, {1, 3}, 3, 1000);
+        std::vector<Graph::Edge> edges;
+        for (int v = 0; v < 20; ++v)
+            for (int w : graph.out(v))
+                edges.emplace_back(formB.labeling[v], formB.labeling[w]);
+        std::sort(edges.begin(), edges.end());
+        REQUIRE(edges == formB.edges);
+    }
+
+    SECTION("AdjList entry point") {
+        Graph::AdjList g1, g2;
+        g1.insert(0, 1); g1.insert(1, 2); g1.insert(2, 0); g1.insert(2, 3);
+        g2.insert(9, 5); g2.insert(5, 7); g2.insert(7, 5); g2.insert(7, 2);
+        Graph::AdjList g3;
+        g3.insert(4, 2); g3.insert(2, 6); g3.insert(6, 4); g3.insert(6, 8);
+
+        REQUIRE(Graph::Canonical::label(g1).certificate == Graph::Canonical::label(g3).certificate);
+        REQUIRE(Graph::Canonical::label(g1).certificate != Graph::Canonical::label(g2).certificate);
+    }
+}
+
+TEST_CASE("Canonical: disjoint unions of cycles", "[canonical]") {
+    // 40 triangles: every node looks alike, so the search relies entirely on
+    // the automorphisms it finds
+    const std::vector<int> triangles(40, 3);
+    std::vector<int> mixed(36, 3);
+    mixed.insert(mixed.end(), {6, 6});
+
+    const auto formA = Graph::Canonical::label(cycles(triangles, 1));
+    const auto formB = Graph::Canonical::label(cycles(triangles, 7));
+    const auto formC = Graph::Canonical::label(cycles(mixed, 1));
+
+    REQUIRE(formA.edges == formB.edges);
+    REQUIRE(formA.certificate == formB.certificate);
+    REQUIRE(formA.certificate != formC.certificate);
+
+    // Only a generating set is kept, not every automorphism met
+    REQUIRE(formA.automorphisms.size() < 120);
+
+    REQUIRE(preservesEdges(cycles(triangles, 1), formA.automorphisms));
+}
+
+TEST_CASE("Canonical: search budget", "[canonical]") {
+    const auto graph = circulant(60, {1}, 1, 0);
+    const auto form = Graph::Canonical::label(graph);
+    REQUIRE(form.complete);
+
+    Graph::SearchBudget ample(100000, std::chrono::milliseconds(60000), nullptr);
+    const auto bounded = Graph::Canonical::label(graph, &ample);
+    REQUIRE(bounded.complete);
+    REQUIRE(bounded.certificate == form.certificate);
+    REQUIRE(ample.spent() > 0);
+
+    Graph::SearchBudget tiny(1, std::chrono::milliseconds(0), nullptr);
+    REQUIRE_FALSE(Graph::Canonical::label(graph, &tiny).complete);
+    REQUIRE(tiny.exhausted());
+
+    std::atomic<bool> cancel{true};
+    Graph::SearchBudget cancelled(0, std::chrono::milliseconds(0), &cancel);
+    REQUIRE_FALSE(Graph::Canonical::label(graph, &cancelled).complete);
+}
+
+TEST_CASE("Canonical: automorphisms without a labeling", "[canonical]") {
+    const auto graph = cycles(std::vector<int>(40, 3), 1);
+    const auto feat = Graph::Feature::genPrint(graph, 1);
+
+    const auto automorphisms = Graph::Canonical::automorphisms(graph, feat);
+    REQUIRE(automorphisms.size() == Graph::Canonical::label(graph).automorphisms.size());
+
+    REQUIRE(preservesEdges(graph, automorphisms));
+
+    // The node cap ends the search early without exhausting the budget
+    Graph::SearchBudget budget;
+    const auto capped = Graph::Canonical::automorphisms(graph, feat, &budget, 200);
+    REQUIRE(capped.size() < automorphisms.size());
+    REQUIRE_FALSE(budget.exhausted());
+}
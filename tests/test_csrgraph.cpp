@@ -0,0 +1,61 @@
+#include "catch.hpp"
+#include "CSRGraph.hpp"
+
+static std::vector<int> toVector(Graph::NodeRange range) {
+    return std::vector<int>(range.begin(), range.end());
+}
+
+TEST_CASE("CSRGraph: built from AdjList", "[csrgraph]") {
+    Graph::AdjList adj;
+    adj.insert(0, 2);
+    adj.insert(0, 1);
+    adj.insert(2, 0);
+    adj.insert(3, 2);
+
+    const Graph::CSRGraph graph(adj);
+
+    REQUIRE(graph.size() == 4);
+    REQUIRE(graph.edgeCount() == 4);
+    REQUIRE(graph.getIds() == std::vector<int>{0, 1, 2, 3});
+
+    SECTION("Sorted forward and reverse neighbors") {
+        REQUIRE(toVector(graph.out(0)) == std::vector<int>{1, 2});
+        REQUIRE(toVector(graph.in(2)) == std::vector<int>{0, 3});
+        REQUIRE(graph.outDegree(1) == 0);
+        REQUIRE(graph.inDegree(1) == 1);
+    }
+
+    SECTION("Edge presence") {
+        REQUIRE(graph.hasEdge(0, 2));
+        REQUIRE(graph.hasEdge(2, 0));
+        REQUIRE_FALSE(graph.hasEdge(2, 3));
+    }
+}
+
+TEST_CASE("CSRGraph: isolated AdjList nodes are kept", "[csrgraph]") {
+    Graph::AdjList adj;
+    adj.insert(1, 2);
+    adj[7];
+
+    const Graph::CSRGraph graph(adj);
+
+    REQUIRE(graph.size() == 3);
+    REQUIRE(graph.edgeCount() == 1);
+    REQUIRE(graph.getIds() == std::vector<int>{1, 2, 7});
+    REQUIRE(graph.outDegree(graph.index(7)) == 0);
+    REQUIRE(graph.inDegree(graph.index(7)) == 0);
+}
+
+TEST_CASE("CSRGraph: sparse IDs are compacted", "[csrgraph]") {
+    const Graph::CSRGraph graph({{2000000000, -7}, {-7, 42}, {42, 2000000000}, {42, 2000000000}});
+
+    REQUIRE(graph.size() == 3);
+    REQUIRE(graph.edgeCount() == 3);
+    REQUIRE(graph.getIds() == std::vector<int>{-7, 42, 2000000000});
+
+    REQUIRE(graph.index(2000000000) == 2);
+    REQUIRE(graph.index(5) == -1);
+    REQUIRE(graph.id(0) == -7);
+    REQUIRE(graph.hasEdge(graph.index(42), graph.index(2000000000)));
+    REQUIRE(toVector(graph.in(graph.index(-7))) == std::vector<int>{2});
+}
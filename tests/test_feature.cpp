@@ -0,0 +1,148 @@
+#include "catch.hpp"
+#include "Feature.hpp"
+
+// Two triangles vs a hexagon, plus the hexagon relabeled (both directions on
+// every edge): every node has degree (2, 2), so 1-WL sees no difference but
+// 2-WL does
+struct CycleFixture {
+    std::vector<Graph::Edge> triangles, hexagon, relabeled;
+};
+
+static CycleFixture cycleFixture() {
+    CycleFixture fixture;
+    auto link = [](std::vector<Graph::Edge>& edges, int u, int v) {
+        edges.emplace_back(u, v);
+        edges.emplace_back(v, u);
+    };
+    for (int n = 0; n < 3; ++n)
+        for (int base : {0, 3})
+            link(fixture.triangles, base + n, base + (n + 1) % 3);
+    for (int n = 0; n < 6; ++n) {
+        link(fixture.hexagon, n, (n + 1) % 6);
+        link(fixture.relabeled, (n * 5 + 2) % 6 + 10, ((n + 1) * 5 + 2) % 6 + 10);
+    }
+    return fixture;
+}
+
+static Graph::AdjList toAdjList(const std::vector<Graph::Edge>& edges) {
+    Graph::AdjList adj;
+    for (const auto& [src, dst] : edges)
+        adj.insert(src, dst);
+    return adj;
+}
+
+TEST_CASE("Feature: distance signatures", "[feature]") {
+    Graph::AdjList adj;
+    adj.insert(0, 1);
+    adj.insert(1, 0);
+    adj.insert(1, 2);
+    adj.insert(2, 2);
+    adj.insert(3, 1);
+
+    const auto feat = Graph::Feature::gen(adj);
+    REQUIRE(feat.size() == 4);
+
+    SECTION("Signed distances from every source") {
+        Graph::FeatSig expected;
+        expected[{1, 1}].insert(Graph::DSet{-1, 1});
+        expected[{2, 2}].insert(Graph::DSet{-2, 0, 2});
+        expected[{1, 2}].insert(Graph::DSet{-3, -1});
+        expected[{1, 0}].insert(Graph::DSet{1, 3});
+
+        REQUIRE(feat.count(expected) == 1);
+        REQUIRE(feat.at(expected) == Graph::NodeSet{1});
+    }
+
+    SECTION("Invariant under relabeling") {
+        Graph::AdjList relabeled;
+        for (const auto& [src, dsts] : adj)
+            for (int dst : dsts)
+                relabeled.insert(100 - src * 3, 100 - dst * 3);
+
+        const auto featRelabeled = Graph::Feature::gen(relabeled);
+        REQUIRE(featRelabeled.size() == feat.size());
+        for (const auto& [sig, nodes] : feat)
+            REQUIRE(featRelabeled.at(sig).size() == nodes.size());
+    }
+}
+
+TEST_CASE("Feature: parallel generation matches sequential", "[feature]") {
+    std::vector<Graph::Edge> edges;
+    for (int n = 0; n < 300; ++n) {
+        edges.emplace_back(n, (n * 7 + 3) % 300);
+        edges.emplace_back(n, (n * n + 11) % 300);
+    }
+    const Graph::CSRGraph graph(edges);
+
+    REQUIRE(Graph::Feature::gen(graph, 4) == Graph::Feature::gen(graph, 1));
+}
+
+TEST_CASE("Feature: fingerprints give the same partition", "[feature]") {
+    std::vector<Graph::Edge> edges;
+    for (int n = 0; n < 200; ++n) {
+        edges.emplace_back(n, (n * 5 + 1) % 200);
+        edges.emplace_back((n * 3) % 200, n);
+    }
+    const Graph::CSRGraph graph(edges);
+
+    auto cells = [](const auto& feat) {
+        std::set<std::vector<int>> result;
+        for (const auto& [_, nodes] : feat)
+            result.insert(Utils::sort(nodes));
+        return result;
+    };
+
+    REQUIRE(cells(Graph::Feature::genPrint(graph, 2)) == cells(Graph::Feature::gen(graph)));
+}
+
+TEST_CASE("Feature: k-WL tuple colors", "[feature]") {
+    // Directed 5-cycle: a pair's color is its offset along the cycle
+    Graph::AdjList adj;
+    for (int n = 0; n < 5; ++n)
+        adj.insert(n * 10, (n + 1) % 5 * 10);
+
+    const auto colors = Graph::Feature::genkWL(adj, 2);
+    REQUIRE(colors.size() == 25);
+
+    std::map<int, int> classSizes;
+    for (int c : colors) ++classSizes[c];
+    REQUIRE(classSizes.size() == 5);
+    for (const auto& [_, size] : classSizes)
+        REQUIRE(size == 5);
+
+    REQUIRE(Graph::Feature::genkWL(Graph::AdjList(), 2).empty());
+}
+
+TEST_CASE("Feature: parallel k-WL matches sequential", "[feature]") {
+    Graph::AdjList adj;
+    for (int n = 0; n < 12; ++n) {
+        adj.insert(n, (n * 5 + 1) % 12);
+        adj.insert((n * 7) % 12, (n + 3) % 12);
+    }
+
+    REQUIRE(Graph::Feature::genkWL(adj, 3, 20, 4) == Graph::Feature::genkWL(adj, 3, 20, 1));
+}
+
+TEST_CASE("Feature: joint k-WL separates non-isomorphic graphs", "[feature]") {
+    const auto fixture = cycleFixture();
+    const auto triangles = toAdjList(fixture.triangles);
+    const auto hexagon = toAdjList(fixture.hexagon);
+    const auto relabeled = toAdjList(fixture.relabeled);
+
+    REQUIRE(Graph::Feature::kWLEquivalent(triangles, hexagon, 1));
+    REQUIRE_FALSE(Graph::Feature::kWLEquivalent(triangles, hexagon, 2));
+    REQUIRE_FALSE(Graph::Feature::kWLEquivalent(triangles, hexagon, 2, 20, 3));
+    REQUIRE(Graph::Feature::kWLEquivalent(hexagon, relabeled, 2));
+    REQUIRE(Graph::Feature::kWLEquivalent(hexagon, relabeled, 3, 20, 3));
+}
+
+TEST_CASE("Feature: local k-WL on connected tuples", "[feature]") {
+    const auto fixture = cycleFixture();
+    const Graph::CSRGraph graphT(fixture.triangles), graphH(fixture.hexagon), graphR(fixture.relabeled);
+
+    REQUIRE(Graph::Feature::localkWLEquivalent(graphT, graphH, 1));
+    REQUIRE_FALSE(Graph::Feature::localkWLEquivalent(graphT, graphH, 2));
+    REQUIRE_FALSE(Graph::Feature::localkWLEquivalent(graphT, graphH, 3, 20, 3));
+    REQUIRE(Graph::Feature::localkWLEquivalent(graphH, graphR, 2));
+    REQUIRE(Graph::Feature::localkWLEquivalent(graphH, graphR, 3, 20, 3));
+}
@@ -0,0 +1,42 @@
+#include "catch.hpp"
+#include "GraphCache.hpp"
+
+static Graph::GraphCache::Ptr makeCached(std::vector<Graph::Edge> edges) {
+    return std::make_shared<const Graph::PreparedGraph>(Graph::CSRGraph(std::move(edges)));
+}
+
+TEST_CASE("GraphCache: loads once and evicts least recently used", "[graphcache]") {
+    const auto path = (Utils::fs::temp_directory_path() / "graphcache_test.csv").string();
+    {
+        std::ofstream file(path);
+        file << "1,2\n2,3\n3,1\n";
+    }
+
+    SECTION("Repeated gets hit the cache") {
+        Graph::GraphCache cache;
+        const auto first = cache.get(path);
+        const auto second = cache.get(path);
+
+        REQUIRE(first == second);
+        REQUIRE(first->getGraph().edgeCount() == 3);
+        REQUIRE(cache.misses() == 1);
+        REQUIRE(cache.hits() == 1);
+    }
+
+    SECTION("Byte limit drops the oldest entry") {
+        const auto a = makeCached({{0, 1}});
+        const auto b = makeCached({{0, 1}, {1, 2}});
+        Graph::GraphCache cache(a->bytes() + b->bytes());
+
+        cache.put("a", a);
+        cache.put("b", b);
+        REQUIRE(cache.size() == 2);
+
+        cache.get(path);
+        REQUIRE_FALSE(cache.contains("a"));
+        REQUIRE(cache.contains(path));
+        REQUIRE(cache.bytes() <= a->bytes() + b->bytes());
+    }
+
+    Utils::fs::remove(path);
+}
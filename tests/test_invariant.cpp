@@ -0,0 +1,18 @@
+#include "catch.hpp"
+#include "Invariant.hpp"
+
+TEST_CASE("Invariant: relabeling-invariant graph hash", "[invariant]") {
+    const Graph::CSRGraph cycle({{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 0}, {0, 2}});
+    const Graph::CSRGraph relabeled({{50, 10}, {10, 40}, {40, 30}, {30, 20}, {20, 50}, {50, 40}});
+    const Graph::CSRGraph longChord({{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 0}, {0, 3}});
+
+    SECTION("Isomorphic graphs hash equal") {
+        REQUIRE(Graph::Invariant::hash(cycle) == Graph::Invariant::hash(relabeled));
+        REQUIRE(Graph::Invariant::hashWL(cycle) == Graph::Invariant::hashWL(relabeled));
+    }
+
+    SECTION("Structural differences change the hash") {
+        REQUIRE(Graph::Invariant::hashDegrees(cycle) == Graph::Invariant::hashDegrees(longChord));
+        REQUIRE(Graph::Invariant::hash(cycle) != Graph::Invariant::hash(longChord));
+    }
+}
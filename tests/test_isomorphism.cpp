@@ -1,5 +1,29 @@
 #include "catch.hpp"
 #include "Isomorphism.hpp"
+#include <algorithm>
+#include <random>
+
+// Circulant digraph v -> v + step (mod n) for every step, relabeled
+// v -> v * scale (mod n) + offset
+static std::vector<Graph::Edge> circulantEdges(int n, std::initializer_list<int> steps, int scale, int offset) {
+    std::vector<Graph::Edge> edges;
+    for (int v = 0; v < n; ++v)
+        for (int step : steps)
+            edges.emplace_back((v * scale) % n + offset, ((v + step) % n * scale) % n + offset);
+    return edges;
+}
+
+static Graph::CSRGraph circulant(int n, std::initializer_list<int> steps, int scale, int offset) {
+    return Graph::CSRGraph(circulantEdges(n, steps, scale, offset));
+}
+
+// Every edge of graphA maps onto an edge of graphB
+static bool preservesEdges(const Graph::CSRGraph& graphA, const Graph::CSRGraph& graphB, const Graph::NodeMap& maps) {
+    for (int v = 0; v < static_cast<int>(graphA.size()); ++v)
+        for (int w : graphA.out(v))
+            if (!graphB.hasEdge(maps[v], maps[w])) return false;
+    return true;
+}
 
 TEST_CASE("Isomorphism: simple test", "[isomorphism]") {
     Graph::AdjList g1;
@@ -21,4 +45,297 @@ TEST_CASE("Isomorphism: simple test", "[isomorphism]") {
     SECTION("Non-isomorphic graphs") {
         REQUIRE(Graph::Isomorphism::solver(g1, g2) == false);
     }
+
+    SECTION("Isolated nodes count") {
+        Graph::AdjList g3 = g1;
+        g3[7];
+        REQUIRE(Graph::Isomorphism::solver(g1, g3) == false);
+
+        Graph::AdjList g4;
+        g4.insert(20, 21);
+        g4.insert(21, 22);
+        g4.insert(22, 20);
+        g4[30];
+        REQUIRE(Graph::Isomorphism::solver(g3, g4) == true);
+    }
+}
+
+TEST_CASE("Isomorphism: mapping uses external IDs", "[isomorphism]") {
+    Graph::AdjList g1;
+    g1.insert(0, 1);
+    g1.insert(1, 2);
+    g1.insert(2, 2);
+
+    Graph::AdjList g2;
+    g2.insert(1000000000, 7);
+    g2.insert(7, 7);
+    g2.insert(-3, 1000000000);
+
+    Graph::IdMap maps;
+    REQUIRE(Graph::Isomorphism::solver(g1, g2, maps) == true);
+    REQUIRE(maps == Graph::IdMap{{0, -3}, {1, 1000000000}, {2, 7}});
+}
+
+TEST_CASE("Isomorphism: prepared graphs", "[isomorphism]") {
+    const Graph::PreparedGraph query(Graph::CSRGraph({{0, 1}, {1, 2}, {2, 3}, {3, 0}, {0, 2}}));
+    const Graph::PreparedGraph same(Graph::CSRGraph({{7, 5}, {5, 9}, {9, 6}, {6, 7}, {7, 9}}));
+    const Graph::PreparedGraph other(Graph::CSRGraph({{0, 1}, {1, 2}, {2, 3}, {3, 0}, {1, 0}}));
+
+    Graph::NodeMap maps;
+    REQUIRE(Graph::Isomorphism::solver(query, same, maps) == true);
+    REQUIRE(preservesEdges(query.getGraph(), same.getGraph(), maps));
+
+    REQUIRE(Graph::Isomorphism::solver(query, other) == false);
+}
+
+TEST_CASE("Isomorphism: parallel search", "[isomorphism]") {
+    // Circulant digraph: every node has the same features, so the search
+    // has to branch on one large group
+    const auto graphA = circulant(24, {1, 5}, 1, 0);
+    auto edgesB = circulantEdges(24, {1, 5}, 7, 100);
+    const Graph::CSRGraph graphB(edgesB);
+
+    Graph::SolverOptions options;
+    options.threads = 4;
+
+    Graph::NodeMap maps;
+    REQUIRE(Graph::Isomorphism::solver(graphA, graphB, maps, options) == true);
+    REQUIRE(preservesEdges(graphA, graphB, maps));
+
+    edgesB.back().second = edgesB.front().second;
+    const Graph::CSRGraph broken(edgesB);
+    REQUIRE(Graph::Isomorphism::solver(graphA, broken, options) == false);
+}
+
+TEST_CASE("Isomorphism: search order follows connectivity", "[isomorphism]") {
+    // Shuffled circulants: one feature group, and node IDs carry no hint of
+    // the structure, so the search has to extend along edges to stay small
+    const int n = 80;
+    std::mt19937 rng(42);
+    std::vector<int> permA(n), permB(n);
+    for (int v = 0; v < n; ++v) permA[v] = permB[v] = v;
+    std::shuffle(permA.begin(), permA.end(), rng);
+    std::shuffle(permB.begin(), permB.end(), rng);
+
+    std::vector<Graph::Edge> edgesA, edgesB;
+    for (int v = 0; v < n; ++v) {
+        for (int step : {1, 23}) {
+            edgesA.emplace_back(permA[v], permA[(v + step) % n]);
+            edgesB.emplace_back(permB[v], permB[(v + step) % n]);
+        }
+    }
+    const Graph::CSRGraph graphA(edgesA), graphB(edgesB);
+
+    Graph::NodeMap maps;
+    REQUIRE(Graph::Isomorphism::solver(graphA, graphB, maps) == true);
+    REQUIRE(preservesEdges(graphA, graphB, maps));
+}
+
+TEST_CASE("Isomorphism: individualization-refinement engine", "[isomorphism]") {
+    const auto graphA = circulant(30, {1, 4, 11}, 1, 0);
+    const auto graphB = circulant(30, {1, 4, 11}, 7, 50);
+    const auto graphC = circulant(30, {1, 4, 13}, 1, 0);
+
+    Graph::SolverOptions options;
+    options.engine = Graph::Engine::Refine;
+
+    Graph::NodeMap maps;
+    REQUIRE(Graph::Isomorphism::solver(graphA, graphB, maps, options) == true);
+    REQUIRE(preservesEdges(graphA, graphB, maps));
+
+    REQUIRE(Graph::Isomorphism::solver(graphA, graphC, options) == false);
+}
+
+TEST_CASE("Isomorphism: automorphism pruning", "[isomorphism]") {
+    const auto graphA = circulant(24, {1, 5}, 1, 0);
+    const auto graphB = circulant(24, {1, 5}, 7, 100);
+    const auto graphC = circulant(24, {1, 7}, 1, 0);
+
+    Graph::SolverOptions options;
+    options.automorphisms = true;
+
+    for (int threads : {1, 4}) {
+        options.threads = threads;
+
+        Graph::NodeMap maps;
+        REQUIRE(Graph::Isomorphism::solver(graphA, graphB, maps, options) == true);
+        REQUIRE(preservesEdges(graphA, graphB, maps));
+
+        REQUIRE(Graph::Isomorphism::solver(graphA, graphC, options) == false);
+    }
+}
+
+TEST_CASE("Isomorphism: automorphism pruning reduces the search", "[isomorphism]") {
+    // 4x4 rook's graph vs the Shrikhande graph: same features everywhere,
+    // so only an exhaustive search tells them apart
+    std::vector<Graph::Edge> edgesR, edgesS;
+    for (int u = 0; u < 16; ++u) {
+        for (int v = 0; v < 16; ++v) {
+            if (u == v) continue;
+            const int dx = (v / 4 - u / 4 + 4) % 4, dy = (v % 4 - u % 4 + 4) % 4;
+            if (dx == 0 || dy == 0)
+                edgesR.emplace_back(u, v);
+            if ((dx == 0 || dy == 0 || dx == dy) && dx % 2 + dy % 2 > 0)
+                edgesS.emplace_back(u, v);
+        }
+    }
+    const Graph::CSRGraph rook(edgesR), shrikhande(edgesS);
+
+    Graph::SolverOptions limited;
+    limited.nodeLimit = 300;
+    Graph::NodeMap maps;
+    REQUIRE(Graph::Isomorphism::match(rook, shrikhande, maps, limited) == Graph::Result::Unknown);
+
+    limited.automorphisms = true;
+    REQUIRE(Graph::Isomorphism::match(rook, shrikhande, maps, limited) == Graph::Result::NotIsomorphic);
+    REQUIRE(Graph::Isomorphism::match(shrikhande, rook, maps, limited) == Graph::Result::NotIsomorphic);
+}
+
+TEST_CASE("Isomorphism: easy pairs skip the automorphism collection", "[isomorphism]") {
+    // 40 disjoint triangles: collecting their automorphisms takes far more
+    // nodes than the search itself
+    std::vector<Graph::Edge> edgesA, edgesB;
+    for (int v = 0; v < 120; ++v) {
+        const int w = v / 3 * 3 + (v + 1) % 3;
+        edgesA.emplace_back(v, w);
+        edgesB.emplace_back(v * 7 % 120, w * 7 % 120);
+    }
+
+    Graph::SolverOptions limited;
+    limited.automorphisms = true;
+    limited.nodeLimit = 200;
+    Graph::NodeMap maps;
+    REQUIRE(Graph::Isomorphism::match(Graph::CSRGraph(edgesA), Graph::CSRGraph(edgesB), maps, limited) ==
+            Graph::Result::Isomorphic);
+}
+
+TEST_CASE("Isomorphism: VF2++ engine", "[isomorphism]") {
+    const auto graphA = circulant(30, {1, 4, 11}, 1, 0);
+    const auto graphB = circulant(30, {1, 4, 11}, 7, 50);
+    const auto graphC = circulant(30, {1, 4, 13}, 1, 0);
+
+    Graph::SolverOptions options;
+    options.engine = Graph::Engine::VF2;
+
+    Graph::NodeMap maps;
+    REQUIRE(Graph::Isomorphism::solver(graphA, graphB, maps, options) == true);
+    REQUIRE(preservesEdges(graphA, graphB, maps));
+
+    REQUIRE(Graph::Isomorphism::solver(graphA, graphC, options) == false);
+
+    // Self-loops and a second component
+    const Graph::CSRGraph loopA({{0, 0}, {0, 1}, {1, 2}, {3, 4}, {4, 3}});
+    const Graph::CSRGraph loopB({{9, 8}, {8, 7}, {9, 9}, {5, 6}, {6, 5}});
+    const Graph::CSRGraph loopC({{0, 0}, {0, 1}, {1, 1}, {3, 4}, {4, 3}});
+    REQUIRE(Graph::Isomorphism::solver(loopA, loopB, options) == true);
+    REQUIRE(Graph::Isomorphism::solver(loopA, loopC, options) == false);
+}
+
+TEST_CASE("Isomorphism: search limits give an unknown result", "[isomorphism]") {
+    const auto graphA = circulant(60, {1, 7}, 1, 0);
+    const auto graphB = circulant(60, {1, 7}, 11, 0);
+    const auto graphC = circulant(60, {1, 13}, 1, 0);
+
+    for (auto engine : {Graph::Engine::Groups, Graph::Engine::Refine, Graph::Engine::VF2}) {
+        Graph::SolverOptions options;
+        options.engine = engine;
+        Graph::NodeMap maps;
+
+        REQUIRE(Graph::Isomorphism::match(graphA, graphB, maps, options) == Graph::Result::Isomorphic);
+        REQUIRE(Graph::Isomorphism::match(graphA, graphC, maps, options) == Graph::Result::NotIsomorphic);
+
+        options.timeLimit = std::chrono::milliseconds(60000);
+        REQUIRE(Graph::Isomorphism::match(graphA, graphB, maps, options) == Graph::Result::Isomorphic);
+
+        options.nodeLimit = 1;
+        REQUIRE(Graph::Isomorphism::match(graphA, graphB, maps, options) == Graph::Result::Unknown);
+        REQUIRE(Graph::Isomorphism::solver(graphA, graphB, options) == false);
+
+        // The automorphism pre-pass draws on the same budget
+        options.automorphisms = true;
+        REQUIRE(Graph::Isomorphism::match(graphA, graphB, maps, options) == Graph::Result::Unknown);
+        options.automorphisms = false;
+
+        std::atomic<bool> cancel{true};
+        options.nodeLimit = 0;
+        options.cancel = &cancel;
+        REQUIRE(Graph::Isomorphism::match(graphA, graphB, maps, options) == Graph::Result::Unknown);
+    }
+
+    Graph::SolverOptions options;
+    options.threads = 4;
+    options.nodeLimit = 2;
+    Graph::NodeMap maps;
+    REQUIRE(Graph::Isomorphism::match(graphA, graphB, maps, options) == Graph::Result::Unknown);
+}
+
+TEST_CASE("Isomorphism: solver statistics", "[isomorphism]") {
+    const int n = 40;
+    std::vector<Graph::Edge> edgesA, edgesB;
+    for (int v = 0; v < n; ++v) {
+        for (int step : {1, 9}) {
+            edgesA.emplace_back(v, (v + step) % n);
+            edgesB.emplace_back((v * 3) % n, ((v + step) % n * 3) % n);
+        }
+    }
+    const Graph::CSRGraph graphA(edgesA), graphB(edgesB);
+
+    for (int threads : {1, 4}) {
+        Graph::SolverStats stats;
+        Graph::SolverOptions options;
+        options.threads = threads;
+        options.stats = &stats;
+        Graph::NodeMap maps;
+
+        REQUIRE(Graph::Isomorphism::match(graphA, graphB, maps, options) == Graph::Result::Isomorphic);
+
+        if (Graph::SolverStats::enabled) {
+            REQUIRE(stats.nodes > 0);
+            REQUIRE(stats.subMappingChecks > 0);
+            REQUIRE(stats.maxDepth == n);
+            REQUIRE(stats.groups > 0);
+            REQUIRE(stats.largestGroup <= (std::size_t)n);
+            REQUIRE(stats.searchBytes > 0);
+            REQUIRE(stats.featureNanos > 0);
+        } else {
+            REQUIRE(stats.nodes == 0);
+            REQUIRE(stats.subMappingChecks == 0);
+            REQUIRE(stats.searchNanos == 0);
+        }
+    }
+}
+
+TEST_CASE("Isomorphism: local k-WL pre-check", "[isomorphism]") {
+    // 4x4 rook's graph vs the Shrikhande graph: both strongly regular with
+    // the same parameters, so every node has the same features and 2-WL
+    // sees no difference; local 3-WL separates them without a search
+    std::vector<Graph::Edge> edgesA, edgesB, edgesC;
+    for (int u = 0; u < 16; ++u) {
+        for (int v = 0; v < 16; ++v) {
+            if (u == v) continue;
+            const int dx = (v / 4 - u / 4 + 4) % 4, dy = (v % 4 - u % 4 + 4) % 4;
+            if (dx == 0 || dy == 0)
+                edgesA.emplace_back(u, v);
+            if ((dx == 0 || dy == 0 || dx == dy) && dx % 2 + dy % 2 > 0) {
+                edgesB.emplace_back(u, v);
+                edgesC.emplace_back((u * 7) % 16, (v * 7) % 16);
+            }
+        }
+    }
+    const Graph::CSRGraph graphA(edgesA), graphB(edgesB), graphC(edgesC);
+
+    for (auto engine : {Graph::Engine::Groups, Graph::Engine::Refine, Graph::Engine::VF2}) {
+        Graph::SolverOptions options;
+        options.engine = engine;
+        options.nodeLimit = 1;
+        Graph::NodeMap maps;
+
+        REQUIRE(Graph::Isomorphism::match(graphA, graphB, maps, options) == Graph::Result::Unknown);
+
+        options.localWL = 3;
+        REQUIRE(Graph::Isomorphism::match(graphA, graphB, maps, options) == Graph::Result::NotIsomorphic);
+
+        options.nodeLimit = 0;
+        REQUIRE(Graph::Isomorphism::match(graphB, graphC, maps, options) == Graph::Result::Isomorphic);
+    }
 }
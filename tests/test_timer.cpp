@@ -0,0 +1,64 @@
+#include "catch.hpp"
+#include "Timer.hpp"
+#include "ThreadPool.hpp"
+#include <sstream>
+#include <thread>
+
+static const Profiler::Phase* findPhase(const std::vector<Profiler::Phase>& phases, const std::string& path) {
+    for (const auto& phase : phases)
+        if (phase.path == path) return &phase;
+    return nullptr;
+}
+
+TEST_CASE("Timer: nanosecond elapsed time", "[timer]") {
+    Timer timer;
+    timer.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    timer.stop();
+
+    REQUIRE(timer.nanos() >= 2000000);
+    REQUIRE(timer.get().size() == std::string("00:00:00.002").size());
+}
+
+TEST_CASE("Profiler: nested and per-thread phases", "[timer]") {
+    Profiler::enable();
+    Profiler::reset();
+
+    {
+        Profiler::Scope outer("outer");
+        for (int i = 0; i < 3; ++i)
+            Profiler::Scope inner("inner");
+    }
+
+    ThreadPool pool(4);
+    pool.run(8, [](int, int) { Profiler::Scope scope("task"); });
+
+    Profiler::enable(false);
+    { Profiler::Scope ignored("ignored"); }
+
+    const auto phases = Profiler::report();
+    const auto* outer = findPhase(phases, "outer");
+    const auto* inner = findPhase(phases, "outer/inner");
+    const auto* task = findPhase(phases, "task");
+
+    REQUIRE(outer);
+    REQUIRE(inner);
+    REQUIRE(task);
+    REQUIRE(findPhase(phases, "ignored") == nullptr);
+
+    REQUIRE(outer->calls == 1);
+    REQUIRE(inner->calls == 3);
+    REQUIRE(inner->nanos <= outer->nanos);
+    REQUIRE(task->calls == 8);
+    REQUIRE(task->threads >= 1);
+
+    std::ostringstream json, trace;
+    Profiler::writeJSON(json);
+    Profiler::writeTrace(trace);
+    REQUIRE(json.str().find("\"path\": \"outer/inner\"") != std::string::npos);
+    REQUIRE(trace.str().find("\"traceEvents\"") != std::string::npos);
+    REQUIRE(trace.str().find("\"name\": \"inner\"") != std::string::npos);
+
+    Profiler::reset();
+    REQUIRE(Profiler::report().empty());
+}